@@ -0,0 +1,148 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 收集性能测试结果并输出为 JSON, 便于比较调度模式和在版本之间发现性能回退.
+// 每条结果由 section (测试项) + name (配置) 唯一标识, value 的含义由 unit 说明
+class BenchReport
+{
+public:
+    struct Result
+    {
+        std::string section;
+        std::string name;
+        double value;
+        std::string unit;
+    };
+
+    void setLabel(std::string text)
+    {
+        label = std::move(text);
+    }
+
+    void beginSection(std::string title)
+    {
+        section = std::move(title);
+    }
+
+    void add(const std::string& name, double value, const std::string& unit)
+    {
+        results.push_back(Result{section, name, value, unit});
+    }
+
+    const std::vector<Result>& getResults() const
+    {
+        return results;
+    }
+
+    bool writeJson(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+
+        out << "{\n";
+        out << "  \"label\": " << quote(label) << ",\n";
+        out << "  \"timestamp\": " << quote(timestamp()) << ",\n";
+        out << "  \"compiler\": " << quote(compiler()) << ",\n";
+#ifdef NDEBUG
+        out << "  \"build\": \"release\",\n";
+#else
+        out << "  \"build\": \"debug\",\n";
+#endif
+        out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"section\": " << quote(result.section)
+                << ", \"name\": " << quote(result.name) << ", \"value\": " << number(result.value)
+                << ", \"unit\": " << quote(result.unit) << "}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    static std::string quote(const std::string& text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '"':
+                quoted += "\\\"";
+                break;
+            case '\\':
+                quoted += "\\\\";
+                break;
+            case '\n':
+                quoted += "\\n";
+                break;
+            case '\t':
+                quoted += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    quoted += escaped;
+                }
+                else
+                {
+                    quoted += c;
+                }
+            }
+        }
+        return quoted + "\"";
+    }
+
+    // JSON 不支持 NaN 与无穷大, 按 null 输出
+    static std::string number(double value)
+    {
+        if (value != value || value > 1e300 || value < -1e300)
+            return "null";
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        return buffer;
+    }
+
+    static std::string timestamp()
+    {
+        const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        return buffer;
+    }
+
+    static std::string compiler()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string label;
+    std::string section;
+    std::vector<Result> results;
+};
@@ -0,0 +1,1311 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <execution>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AdaptiveInvokeStrategy.hpp"
+#include "Attribute.hpp"
+#include "BenchReport.hpp"
+#include "Event.hpp"
+#include "EventLoopInvokeStrategy.hpp"
+#include "InlineInvokeStrategy.hpp"
+#include "ParallelAlgorithms.hpp"
+#include "SnapshotCell.hpp"
+#include "TaskGroup.hpp"
+#include "ThreadPool.hpp"
+#include "ThreadPoolInvokeStrategy.hpp"
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE [[gnu::noinline]]
+#endif
+
+namespace
+{
+std::atomic<size_t> g_allocationCount{0};
+BenchReport g_report;
+
+constexpr size_t TaskCount = 100000;
+constexpr size_t ThreadCount = 4;
+
+void waitUntil(const std::atomic<size_t>& counter, size_t expected)
+{
+    while (counter.load(std::memory_order_acquire) < expected)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void printSection(const std::string& title)
+{
+    std::cout << "=== " << title << " ===" << std::endl;
+    g_report.beginSection(title);
+}
+
+// 按统一格式输出一行结果并记入报告
+void printResult(const std::string& name, double value, const std::string& unit, int precision = 1)
+{
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(precision) << value << " " << unit << std::endl;
+    g_report.add(name, value, unit);
+}
+
+void printAllocations(const std::string& name, size_t allocations, size_t tasks)
+{
+    g_report.add(name, static_cast<double>(allocations) / static_cast<double>(tasks), "allocs/task");
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << allocations << " allocs"
+              << std::setw(12) << std::fixed << std::setprecision(3)
+              << static_cast<double>(allocations) / static_cast<double>(tasks) << " allocs/task" << std::endl;
+}
+
+// 统计每种提交方式下每个任务的平均堆分配次数, 预热一轮让队列缓冲区增长到稳定容量
+template<typename Submit>
+size_t countAllocations(Submit submit, std::atomic<size_t>& done)
+{
+    for (int round = 0; round < 2; ++round)
+    {
+        done = 0;
+        size_t before = g_allocationCount.load();
+        for (size_t i = 0; i < TaskCount; ++i)
+        {
+            submit();
+        }
+        waitUntil(done, TaskCount);
+        if (round == 1)
+        {
+            return g_allocationCount.load() - before;
+        }
+    }
+    return 0;
+}
+
+void benchAllocationsPerTask()
+{
+    printSection("Heap allocations per task (" + std::to_string(TaskCount) + " tasks)");
+    std::atomic<size_t> done{0};
+
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        const std::string modeName = mode == SchedulingMode::SharedQueue ? "shared" : "stealing";
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+
+        size_t allocations = countAllocations(
+            [&]() { pool.post([&done]() { done.fetch_add(1, std::memory_order_release); }); }, done);
+        printAllocations("ThreadPool::post [" + modeName + "]", allocations, TaskCount);
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(TaskCount * 2);
+        allocations = countAllocations(
+            [&]() { futures.push_back(pool.enqueue([&done]() { done.fetch_add(1, std::memory_order_release); })); },
+            done);
+        futures.clear();
+        printAllocations("ThreadPool::enqueue [" + modeName + "]", allocations, TaskCount);
+    }
+
+    comm::ThreadPoolInvokeStrategy strategy(ThreadCount);
+    size_t allocations = countAllocations(
+        [&]() { strategy.invoke([&done]() { done.fetch_add(1, std::memory_order_release); }); }, done);
+    printAllocations("ThreadPoolInvokeStrategy::invoke", allocations, TaskCount);
+}
+
+void spinFor(std::chrono::nanoseconds duration)
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+// 多次运行取最短耗时, 单位毫秒
+template<typename Function>
+double bestOf(int runs, Function&& function)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < runs; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+void printTiming(const std::string& name, double milliseconds)
+{
+    g_report.add(name, milliseconds, "ms");
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(3) << milliseconds << " ms" << std::endl;
+}
+
+// 并行算法与标准库执行策略对比 (libstdc++ 的 std::execution::par 在链接 TBB 时由 TBB 调度)
+void benchParallelAlgorithms(size_t maxElements)
+{
+    const size_t threads = std::thread::hardware_concurrency();
+    ThreadPool pool(threads, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    const ParallelOptions staticOptions{Partitioner::Static, 0};
+    const ParallelOptions adaptiveOptions{Partitioner::Adaptive, 0};
+
+    for (size_t elements = 1000000; elements <= maxElements; elements *= 10)
+    {
+        printSection("Parallel algorithms, " + std::to_string(elements) + " doubles, " + std::to_string(threads) +
+                     " threads");
+        std::vector<double> input(elements);
+        std::iota(input.begin(), input.end(), 1.0);
+        std::vector<double> output(elements);
+        auto transform = [](double x) { return std::sqrt(x) * 1.5 + 1.0; };
+
+        printTiming("for_each std::execution::par", bestOf(3, [&]() {
+            std::for_each(std::execution::par, output.begin(), output.end(), [](double& x) { x = std::sqrt(x + 1.0); });
+        }));
+        printTiming("parallelFor static", bestOf(3, [&]() {
+            parallelFor(pool, output.begin(), output.end(), [](double& x) { x = std::sqrt(x + 1.0); }, staticOptions);
+        }));
+        printTiming("parallelFor adaptive", bestOf(3, [&]() {
+            parallelFor(pool, output.begin(), output.end(), [](double& x) { x = std::sqrt(x + 1.0); }, adaptiveOptions);
+        }));
+
+        double sink = 0;
+        printTiming("reduce std::execution::par", bestOf(3, [&]() {
+            sink += std::reduce(std::execution::par, input.begin(), input.end(), 0.0);
+        }));
+        printTiming("parallelReduce static", bestOf(3, [&]() {
+            sink += parallelReduce(pool, input.begin(), input.end(), 0.0, std::plus<>{}, staticOptions);
+        }));
+        printTiming("parallelReduce adaptive", bestOf(3, [&]() {
+            sink += parallelReduce(pool, input.begin(), input.end(), 0.0, std::plus<>{}, adaptiveOptions);
+        }));
+
+        printTiming("transform std::execution::par", bestOf(3, [&]() {
+            std::transform(std::execution::par, input.begin(), input.end(), output.begin(), transform);
+        }));
+        printTiming("parallelTransform static", bestOf(3, [&]() {
+            parallelTransform(pool, input.begin(), input.end(), output.begin(), transform, staticOptions);
+        }));
+        printTiming("parallelTransform adaptive", bestOf(3, [&]() {
+            parallelTransform(pool, input.begin(), input.end(), output.begin(), transform, adaptiveOptions);
+        }));
+
+        printTiming("inclusive_scan std::execution::par", bestOf(3, [&]() {
+            std::inclusive_scan(std::execution::par, input.begin(), input.end(), output.begin());
+        }));
+        printTiming("parallelScan", bestOf(3, [&]() {
+            parallelScan(pool, input.begin(), input.end(), output.begin());
+        }));
+        if (sink < 0)
+            std::cout << sink << std::endl;
+    }
+}
+
+void printLatency(const std::string& name, const LatencyHistogram& histogram)
+{
+    HistogramSnapshot snapshot;
+    snapshot.merge(histogram);
+    const LatencySummary summary = snapshot.summary();
+    g_report.add(name + " p50", summary.p50, "ns");
+    g_report.add(name + " p99", summary.p99, "ns");
+    g_report.add(name + " p999", summary.p999, "ns");
+    std::cout << std::left << std::setw(40) << name << std::right << " p50 " << std::setw(8) << summary.p50
+              << "ns  p99 " << std::setw(8) << summary.p99 << "ns  p999 " << std::setw(8) << summary.p999 << "ns"
+              << std::endl;
+}
+
+// 乒乓延迟: 提交方发出一个任务后自旋等待它执行完, 统计往返时间. 两次提交之间工作线程已经空闲,
+// Block 模式下每次都要经过 futex 唤醒, 自旋/忙轮询模式下工作线程自己发现新任务
+void benchWakeupLatency()
+{
+    constexpr size_t RoundTrips = 20000;
+    printSection("Ping-pong round trip (" + std::to_string(RoundTrips) + " round trips)");
+    const std::pair<const char*, WaitMode> modes[] = {
+        {"Block", WaitMode::Block},
+        {"SpinThenPark", WaitMode::SpinThenPark},
+        {"BusyPoll", WaitMode::BusyPoll},
+    };
+
+    for (const auto& [name, waitMode] : modes)
+    {
+        ThreadPoolOptions options{SchedulingMode::WorkStealing};
+        options.waitStrategy.mode = waitMode;
+        ThreadPool pool(1, options);
+        std::atomic<size_t> pong{0};
+        LatencyHistogram latency;
+        for (size_t i = 1; i <= RoundTrips; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            pool.post([&pong]() { pong.fetch_add(1, std::memory_order_release); });
+            waitUntil(pong, i);
+            latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                    .count()));
+        }
+        printLatency(std::string("ThreadPool ") + name, latency);
+    }
+
+    for (const auto& [name, waitMode] : modes)
+    {
+        comm::InvokeStrategyOptions strategyOptions;
+        strategyOptions.waitStrategy.mode = waitMode;
+        comm::ThreadPoolInvokeStrategy strategy(1, strategyOptions);
+        std::atomic<size_t> pong{0};
+        LatencyHistogram latency;
+        for (size_t i = 1; i <= RoundTrips; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            strategy.invoke([&pong]() { pong.fetch_add(1, std::memory_order_release); });
+            waitUntil(pong, i);
+            latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                    .count()));
+        }
+        printLatency(std::string("ThreadPoolInvokeStrategy ") + name, latency);
+    }
+}
+
+// 访存密集任务: 每个任务首次访问 (按 first-touch 策略分配到所在节点) 并反复扫描自己的缓冲区,
+// 对比各绑定策略下的聚合带宽. 不绑定时线程跨插槽迁移后会访问远端内存
+void benchAffinityBandwidth()
+{
+    constexpr size_t BufferBytes = size_t{32} << 20;
+    constexpr int Passes = 8;
+    const size_t threads = std::thread::hardware_concurrency();
+
+    printSection("Memory-bound streaming, " + std::to_string(threads) + " tasks x " +
+                 std::to_string(BufferBytes >> 20) + "MB x " + std::to_string(Passes) + " passes, " +
+                 std::to_string(CpuTopology::instance().nodeCount()) + " NUMA node(s)");
+    const std::pair<const char*, AffinityMode> modes[] = {
+        {"AffinityMode::None", AffinityMode::None},
+        {"AffinityMode::Compact", AffinityMode::Compact},
+        {"AffinityMode::Scatter", AffinityMode::Scatter},
+        {"AffinityMode::NumaPartitioned", AffinityMode::NumaPartitioned},
+    };
+    for (const auto& [name, affinityMode] : modes)
+    {
+        ThreadPoolOptions options{SchedulingMode::WorkStealing};
+        options.affinity.mode = affinityMode;
+        ThreadPool pool(threads, options);
+
+        std::atomic<uint64_t> sink{0};
+        auto stream = [&sink]()
+        {
+            std::vector<uint64_t> buffer(BufferBytes / sizeof(uint64_t));
+            std::iota(buffer.begin(), buffer.end(), uint64_t{0});
+            uint64_t sum = 0;
+            for (int pass = 0; pass < Passes; ++pass)
+            {
+                sum = std::accumulate(buffer.begin(), buffer.end(), sum);
+            }
+            sink.fetch_add(sum, std::memory_order_relaxed);
+        };
+        const double milliseconds = bestOf(3,
+                                           [&]()
+                                           {
+                                               std::vector<std::future<void>> futures;
+                                               for (size_t t = 0; t < threads; ++t)
+                                               {
+                                                   futures.push_back(pool.enqueue(stream));
+                                               }
+                                               for (auto& future : futures)
+                                               {
+                                                   future.get();
+                                               }
+                                           });
+        const double gigabytes = static_cast<double>(threads * BufferBytes * (Passes + 1)) / 1e9;
+        printResult(name, gigabytes / (milliseconds / 1000.0), "GB/s", 2);
+    }
+}
+
+// 低优先级任务把线程池打满的情况下, 周期性提交探测任务, 统计提交到开始执行的延迟
+void benchPriorityLatency()
+{
+    constexpr size_t BackgroundTasks = 20000;
+    constexpr size_t ProbeTasks = 200;
+    constexpr auto BackgroundCost = std::chrono::microseconds(50);
+    constexpr auto ProbeInterval = std::chrono::milliseconds(1);
+
+    printSection("Probe submit-to-start latency under saturating low-priority load");
+    for (auto probePriority : {TaskPriority::Normal, TaskPriority::High})
+    {
+        // 基线: 背景任务与探测任务同在普通 FIFO 通道; 对照: 背景任务走低优先级通道, 探测任务走高优先级通道
+        const auto backgroundPriority = probePriority == TaskPriority::High ? TaskPriority::Low : TaskPriority::Normal;
+        ThreadPool pool(ThreadCount);
+        for (size_t i = 0; i < BackgroundTasks; ++i)
+        {
+            pool.post(backgroundPriority, [BackgroundCost]() { spinFor(BackgroundCost); });
+        }
+
+        LatencyHistogram probeLatency;
+        std::vector<std::future<void>> probes;
+        for (size_t i = 0; i < ProbeTasks; ++i)
+        {
+            auto submitted = std::chrono::steady_clock::now();
+            probes.push_back(pool.enqueue(probePriority,
+                                          [&probeLatency, submitted]()
+                                          {
+                                              auto waited = std::chrono::steady_clock::now() - submitted;
+                                              probeLatency.record(static_cast<uint64_t>(
+                                                  std::chrono::duration_cast<std::chrono::nanoseconds>(waited)
+                                                      .count()));
+                                          }));
+            std::this_thread::sleep_for(ProbeInterval);
+        }
+        for (auto& probe : probes)
+        {
+            probe.get();
+        }
+
+        HistogramSnapshot snapshot;
+        snapshot.merge(probeLatency);
+        LatencySummary summary = snapshot.summary();
+        const std::string name =
+            probePriority == TaskPriority::High ? "High probes / Low background" : "FIFO probes / FIFO background";
+        g_report.add(name + " p50", summary.p50 / 1000, "us");
+        g_report.add(name + " p99", summary.p99 / 1000, "us");
+        g_report.add(name + " max", summary.max / 1000, "us");
+        std::cout << std::left << std::setw(40) << name << std::right << " p50 " << std::setw(10)
+                  << summary.p50 / 1000 << "us  p99 " << std::setw(10) << summary.p99 / 1000 << "us  max "
+                  << std::setw(10) << summary.max / 1000 << "us" << std::endl;
+    }
+}
+
+// 突发提交远超处理能力的任务, 比较无界队列与各溢出策略下的峰值排队数与总耗时
+void benchBoundedBurst()
+{
+    constexpr size_t BurstTasks = 200000;
+    constexpr size_t Capacity = 1024;
+    constexpr auto TaskCost = std::chrono::microseconds(1);
+
+    printSection("Burst of " + std::to_string(BurstTasks) + " tasks, capacity " + std::to_string(Capacity));
+    const std::vector<std::pair<std::string, OverflowPolicy>> policies = {
+        {"Block", OverflowPolicy::Block},
+        {"Reject", OverflowPolicy::Reject},
+        {"DropOldest", OverflowPolicy::DropOldest},
+        {"CallerRuns", OverflowPolicy::CallerRuns},
+    };
+    for (size_t bounded = 0; bounded <= policies.size(); ++bounded)
+    {
+        ThreadPoolOptions options;
+        std::string name = "Unbounded";
+        if (bounded > 0)
+        {
+            options.capacity = Capacity;
+            options.overflowPolicy = policies[bounded - 1].second;
+            name = policies[bounded - 1].first;
+        }
+        ThreadPool pool(ThreadCount, options);
+
+        std::atomic<size_t> done{0};
+        size_t peakQueue = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < BurstTasks; ++i)
+        {
+            try
+            {
+                pool.post(
+                    [&done, TaskCost]()
+                    {
+                        spinFor(TaskCost);
+                        done.fetch_add(1, std::memory_order_release);
+                    });
+            }
+            catch (const QueueFullError&)
+            {
+            }
+            if ((i & 255) == 0)
+                peakQueue = std::max(peakQueue, pool.getQueueSize());
+        }
+        waitUntil(done, BurstTasks - pool.getRejectedTasks() - pool.getDroppedTasks());
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        g_report.add(name + " peak queue", static_cast<double>(peakQueue), "tasks");
+        g_report.add(name + " elapsed", elapsed, "ms");
+        std::cout << std::left << std::setw(40) << name << std::right << " peak queue " << std::setw(8) << peakQueue
+                  << "  rejected " << std::setw(8) << pool.getRejectedTasks() << "  dropped " << std::setw(8)
+                  << pool.getDroppedTasks() << std::setw(10) << std::fixed << std::setprecision(2) << elapsed << " ms"
+                  << std::endl;
+    }
+}
+
+// 廉价 listener 在各调用策略下的平均通知耗时: 从 notify 到 listener 执行完
+void benchInvokeStrategies()
+{
+    constexpr size_t Notifications = 200000;
+
+    printSection("Cheap listener, " + std::to_string(Notifications) + " notifications");
+    auto run = [](const std::string& name, comm::IInvokeStrategy& strategy, const std::function<void()>& drain)
+    {
+        comm::Event<size_t> event(strategy);
+        std::atomic<size_t> received{0};
+        auto subscription = event.subscribe([&received](size_t) { received.fetch_add(1, std::memory_order_release); });
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < Notifications; ++i)
+        {
+            event.notify(i);
+        }
+        drain();
+        waitUntil(received, Notifications);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printResult(name, elapsed / Notifications, "ns/notify");
+    };
+
+    comm::InlineInvokeStrategy inlineStrategy;
+    run("InlineInvokeStrategy", inlineStrategy, []() {});
+
+    comm::EventLoopInvokeStrategy loop;
+    run("EventLoopInvokeStrategy", loop, [&loop]() { loop.runOnce(); });
+
+    comm::ThreadPoolInvokeStrategy pool(ThreadCount);
+    run("ThreadPoolInvokeStrategy", pool, []() {});
+
+    comm::AdaptiveInvokeStrategy adaptive(pool);
+    run("AdaptiveInvokeStrategy", adaptive, []() {});
+}
+
+// 空任务的吞吐量随计时方式变化, 反映计时本身的开销
+void benchTimingOverhead()
+{
+    constexpr size_t Tasks = 1000000;
+
+    printSection("Timing overhead, " + std::to_string(Tasks) + " empty tasks");
+    const std::vector<std::pair<std::string, TimingOptions>> configs = {
+        {"steady_clock every task", {TimingMode::SteadyClock, 1}},
+        {"TSC every task", {TimingMode::Tsc, 1}},
+        {"TSC 1-in-64", {TimingMode::Tsc, 64}},
+        {"Off", {TimingMode::Off, 1}},
+    };
+    for (const auto& [name, timing] : configs)
+    {
+        ThreadPoolOptions options{SchedulingMode::WorkStealing};
+        options.timing = timing;
+        ThreadPool pool(ThreadCount, options);
+        std::atomic<size_t> done{0};
+        const double milliseconds = bestOf(
+            3,
+            [&]()
+            {
+                done = 0;
+                for (size_t i = 0; i < Tasks; ++i)
+                {
+                    pool.post([&done]() { done.fetch_add(1, std::memory_order_release); });
+                }
+                waitUntil(done, Tasks);
+            });
+        printResult(name, milliseconds * 1e6 / Tasks, "ns/task");
+    }
+}
+
+// 按 key 串行的两种做法: 每个 key 一把锁 vs enqueueKeyed 的无锁串行队列
+void benchKeyedTasks()
+{
+    constexpr size_t Tasks = 1000000;
+    constexpr size_t Keys = 64;
+
+    printSection("Keyed tasks, " + std::to_string(Tasks) + " tasks over " + std::to_string(Keys) + " keys");
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        const std::string modeName = mode == SchedulingMode::SharedQueue ? "SharedQueue" : "WorkStealing";
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        std::array<std::mutex, Keys> mutexes;
+        std::array<size_t, Keys> counters{};
+        std::atomic<size_t> done{0};
+
+        const double locked = bestOf(
+            3,
+            [&]()
+            {
+                done = 0;
+                for (size_t i = 0; i < Tasks; ++i)
+                {
+                    pool.post(
+                        [&, key = i % Keys]()
+                        {
+                            std::lock_guard<std::mutex> lock(mutexes[key]);
+                            counters[key]++;
+                            done.fetch_add(1, std::memory_order_release);
+                        });
+                }
+                waitUntil(done, Tasks);
+            });
+        const double keyed = bestOf(
+            3,
+            [&]()
+            {
+                done = 0;
+                for (size_t i = 0; i < Tasks; ++i)
+                {
+                    pool.postKeyed(i % Keys,
+                                   [&, key = i % Keys]()
+                                   {
+                                       counters[key]++;
+                                       done.fetch_add(1, std::memory_order_release);
+                                   });
+                }
+                waitUntil(done, Tasks);
+            });
+        printResult(modeName + " per-key mutex", locked * 1e6 / Tasks, "ns/task");
+        printResult(modeName + " enqueueKeyed", keyed * 1e6 / Tasks, "ns/task");
+    }
+}
+
+// 1M 个未到期定时器的插入与取消开销
+void benchTimers()
+{
+    constexpr size_t Timers = 1000000;
+
+    printSection("Timer wheel, " + std::to_string(Timers) + " pending timers");
+    ThreadPool pool(ThreadCount);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> delayDis(1000, 3600000);
+    std::vector<std::chrono::milliseconds> delays(Timers);
+    for (auto& delay : delays)
+    {
+        delay = std::chrono::milliseconds(delayDis(gen));
+    }
+    std::vector<TimerId> ids(Timers);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Timers; ++i)
+    {
+        ids[i] = pool.scheduleAfter(delays[i], []() {});
+    }
+    const double insertNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / Timers;
+    const size_t pending = pool.getPendingTimers();
+
+    start = std::chrono::steady_clock::now();
+    for (const TimerId& id : ids)
+    {
+        pool.cancelTimer(id);
+    }
+    const double cancelNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / Timers;
+
+    printResult("scheduleAfter (" + std::to_string(pending) + " pending)", insertNs, "ns/timer");
+    printResult("cancelTimer (" + std::to_string(pool.getPendingTimers()) + " pending)", cancelNs, "ns/timer");
+}
+
+std::string modeName(SchedulingMode mode)
+{
+    return mode == SchedulingMode::SharedQueue ? "SharedQueue" : "WorkStealing";
+}
+
+// 空任务吞吐量: 单个提交线程连续提交, 衡量每个任务的调度开销
+void benchEmptyTaskThroughput()
+{
+    constexpr size_t Tasks = 1000000;
+
+    printSection("Empty-task throughput, " + std::to_string(Tasks) + " tasks, " + std::to_string(ThreadCount) +
+                 " threads");
+    std::atomic<size_t> done{0};
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        const double milliseconds = bestOf(3,
+                                           [&]()
+                                           {
+                                               done = 0;
+                                               for (size_t i = 0; i < Tasks; ++i)
+                                               {
+                                                   pool.post([&done]()
+                                                             { done.fetch_add(1, std::memory_order_release); });
+                                               }
+                                               waitUntil(done, Tasks);
+                                           });
+        printResult("ThreadPool::post [" + modeName(mode) + "]", Tasks / milliseconds / 1000.0, "Mtasks/s", 2);
+    }
+
+    comm::ThreadPoolInvokeStrategy strategy(ThreadCount);
+    const double milliseconds = bestOf(3,
+                                       [&]()
+                                       {
+                                           done = 0;
+                                           for (size_t i = 0; i < Tasks; ++i)
+                                           {
+                                               strategy.invoke([&done]()
+                                                               { done.fetch_add(1, std::memory_order_release); });
+                                           }
+                                           waitUntil(done, Tasks);
+                                       });
+    printResult("ThreadPoolInvokeStrategy::invoke", Tasks / milliseconds / 1000.0, "Mtasks/s", 2);
+}
+
+// 提交到开始执行的延迟: 每隔约 5us 提交一个任务形成稳定的中等负载, 任务记录从提交到开始执行的时间
+void benchSubmitToStartLatency()
+{
+    constexpr size_t Tasks = 50000;
+    constexpr auto Interval = std::chrono::microseconds(5);
+
+    printSection("Submit-to-start latency, " + std::to_string(Tasks) + " tasks every 5us");
+    auto measure = [Interval](const std::string& name, auto&& submit)
+    {
+        LatencyHistogram latency;
+        std::atomic<size_t> done{0};
+        for (size_t i = 0; i < Tasks; ++i)
+        {
+            const auto submitted = std::chrono::steady_clock::now();
+            submit(
+                [&latency, &done, submitted]()
+                {
+                    latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                             std::chrono::steady_clock::now() - submitted)
+                                                             .count()));
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            spinFor(Interval);
+        }
+        waitUntil(done, Tasks);
+        printLatency(name, latency);
+    };
+
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        measure("ThreadPool::post [" + modeName(mode) + "]",
+                [&pool](auto task) { pool.post(std::move(task)); });
+    }
+    comm::ThreadPoolInvokeStrategy strategy(ThreadCount);
+    measure("ThreadPoolInvokeStrategy::invoke", [&strategy](auto task) { strategy.invoke(std::move(task)); });
+}
+
+// 分叉/汇合: 每轮由一个工作线程上的任务分出 FanOut 个约 1us 的子任务并等待全部完成, 等待期间协助执行子任务
+void benchFanOutFanIn()
+{
+    constexpr size_t Rounds = 2000;
+    constexpr size_t FanOut = 64;
+    constexpr auto ChildCost = std::chrono::microseconds(1);
+
+    printSection("Fan-out/fan-in, " + std::to_string(Rounds) + " rounds x " + std::to_string(FanOut) + " children");
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        const double futures = bestOf(3,
+                                      [&]()
+                                      {
+                                          pool.enqueue(
+                                                  [&]()
+                                                  {
+                                                      std::vector<std::future<void>> children;
+                                                      children.reserve(FanOut);
+                                                      for (size_t round = 0; round < Rounds; ++round)
+                                                      {
+                                                          for (size_t i = 0; i < FanOut; ++i)
+                                                          {
+                                                              children.push_back(
+                                                                  pool.enqueue([ChildCost]() { spinFor(ChildCost); }));
+                                                          }
+                                                          for (auto& child : children)
+                                                          {
+                                                              pool.wait(child);
+                                                          }
+                                                          children.clear();
+                                                      }
+                                                  })
+                                              .get();
+                                      });
+        printResult("enqueue + wait [" + modeName(mode) + "]", futures * 1000.0 / Rounds, "us/round", 2);
+
+        const double group = bestOf(3,
+                                    [&]()
+                                    {
+                                        pool.enqueue(
+                                                [&]()
+                                                {
+                                                    for (size_t round = 0; round < Rounds; ++round)
+                                                    {
+                                                        TaskGroup children(pool);
+                                                        for (size_t i = 0; i < FanOut; ++i)
+                                                        {
+                                                            children.post([ChildCost]() { spinFor(ChildCost); });
+                                                        }
+                                                        children.wait();
+                                                    }
+                                                })
+                                            .get();
+                                    });
+        printResult("TaskGroup [" + modeName(mode) + "]", group * 1000.0 / Rounds, "us/round", 2);
+    }
+}
+
+// 线程数扩展性: 细粒度任务 (约 200ns) 由工作线程上的种子任务分出, 进入本地队列并被其它线程窃取.
+// 线程数从 1 倍增到 min(64, 硬件线程数), 输出吞吐量和相对单线程的加速比
+void benchThreadScaling()
+{
+    constexpr size_t Seeds = 256;
+    constexpr size_t ChildrenPerSeed = 4096;
+    constexpr size_t Tasks = Seeds * ChildrenPerSeed;
+    constexpr auto TaskCost = std::chrono::nanoseconds(200);
+    const size_t maxThreads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 64);
+
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    printSection("Thread scaling, " + std::to_string(Tasks) + " tasks of ~200ns");
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        double singleThread = 0.0;
+        for (size_t threads : threadCounts)
+        {
+            ThreadPool pool(threads, ThreadPoolOptions{mode});
+            std::atomic<size_t> done{0};
+            const double milliseconds = bestOf(3,
+                                               [&]()
+                                               {
+                                                   done = 0;
+                                                   for (size_t seed = 0; seed < Seeds; ++seed)
+                                                   {
+                                                       pool.post(
+                                                           [&]()
+                                                           {
+                                                               for (size_t i = 0; i < ChildrenPerSeed; ++i)
+                                                               {
+                                                                   pool.post(
+                                                                       [&done, TaskCost]()
+                                                                       {
+                                                                           spinFor(TaskCost);
+                                                                           done.fetch_add(1, std::memory_order_release);
+                                                                       });
+                                                               }
+                                                           });
+                                                   }
+                                                   waitUntil(done, Tasks);
+                                               });
+            const double throughput = Tasks / milliseconds / 1000.0;
+            if (threads == 1)
+                singleThread = throughput;
+            printResult(modeName(mode) + ", " + std::to_string(threads) + " thread(s)", throughput, "Mtasks/s", 2);
+            printResult(modeName(mode) + ", " + std::to_string(threads) + " thread(s) speedup",
+                        throughput / singleThread, "x", 2);
+        }
+    }
+}
+
+// 提交方竞争: 1..N 个线程同时提交空任务, 衡量提交路径在竞争下的可扩展性
+void benchProducerContention()
+{
+    constexpr size_t Tasks = 400000;
+
+    printSection("Producer contention, " + std::to_string(Tasks) + " empty tasks");
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        for (size_t producers = 1; producers <= ThreadCount; producers *= 2)
+        {
+            const size_t perProducer = Tasks / producers;
+            std::atomic<size_t> done{0};
+            auto produce = [&]()
+            {
+                for (size_t i = 0; i < perProducer; ++i)
+                {
+                    pool.post([&done]() { done.fetch_add(1, std::memory_order_release); });
+                }
+            };
+            const double milliseconds = bestOf(3,
+                                               [&]()
+                                               {
+                                                   done = 0;
+                                                   std::vector<std::thread> threads;
+                                                   for (size_t p = 0; p < producers; ++p)
+                                                   {
+                                                       threads.emplace_back(produce);
+                                                   }
+                                                   for (auto& thread : threads)
+                                                   {
+                                                       thread.join();
+                                                   }
+                                                   waitUntil(done, perProducer * producers);
+                                               });
+            printResult(modeName(mode) + ", " + std::to_string(producers) + " producer(s)",
+                        milliseconds * 1e6 / static_cast<double>(perProducer * producers), "ns/task");
+        }
+    }
+}
+
+// 混合任务粒度: 90% 约 100ns, 9% 约 10us, 1% 约 1ms. 理想耗时为总工作量除以线程数, 效率为理想耗时与实际耗时之比
+void benchMixedTaskSizes()
+{
+    constexpr size_t Tasks = 20000;
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::chrono::nanoseconds> costs(Tasks);
+    std::chrono::nanoseconds total{0};
+    for (auto& cost : costs)
+    {
+        const int roll = percent(gen);
+        cost = roll < 90 ? std::chrono::nanoseconds(100)
+                         : (roll < 99 ? std::chrono::nanoseconds(10000) : std::chrono::nanoseconds(1000000));
+        total += cost;
+    }
+    const double idealMilliseconds = std::chrono::duration<double, std::milli>(total).count() / ThreadCount;
+
+    printSection("Mixed task sizes, " + std::to_string(Tasks) + " tasks (90% 100ns, 9% 10us, 1% 1ms)");
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool pool(ThreadCount, ThreadPoolOptions{mode});
+        std::atomic<size_t> done{0};
+        const double milliseconds = bestOf(3,
+                                           [&]()
+                                           {
+                                               done = 0;
+                                               for (const auto& cost : costs)
+                                               {
+                                                   pool.post(
+                                                       [&done, cost]()
+                                                       {
+                                                           spinFor(cost);
+                                                           done.fetch_add(1, std::memory_order_release);
+                                                       });
+                                               }
+                                               waitUntil(done, Tasks);
+                                           });
+        printResult(modeName(mode) + " elapsed", milliseconds, "ms", 2);
+        printResult(modeName(mode) + " efficiency", idealMilliseconds / milliseconds * 100.0, "%");
+    }
+}
+
+// 50 个订阅者的同步通知: 读锁收集订阅 vs 原子加载订阅快照
+void benchNotifyModes()
+{
+    constexpr size_t Subscribers = 50;
+    constexpr size_t Notifications = 200000;
+
+    printSection("Notify " + std::to_string(Subscribers) + " subscribers, " + std::to_string(Notifications) +
+                 " notifications");
+    for (auto notifyMode : {comm::NotifyMode::Locked, comm::NotifyMode::Snapshot})
+    {
+        auto event = std::make_shared<comm::EventSync<int>>(notifyMode);
+        std::atomic<size_t> received{0};
+        std::vector<comm::EventSync<int>::SubscriptionPtr> subscriptions;
+        for (size_t i = 0; i < Subscribers; ++i)
+        {
+            subscriptions.push_back(
+                event->subscribe([&received](int) { received.fetch_add(1, std::memory_order_relaxed); }));
+        }
+        const size_t before = g_allocationCount.load();
+        const double milliseconds = bestOf(3,
+                                           [&]()
+                                           {
+                                               for (size_t i = 0; i < Notifications; ++i)
+                                               {
+                                                   event->notify(static_cast<int>(i));
+                                               }
+                                           });
+        const double allocations = static_cast<double>(g_allocationCount.load() - before) / (3.0 * Notifications);
+        const std::string name = notifyMode == comm::NotifyMode::Locked ? "NotifyMode::Locked" : "NotifyMode::Snapshot";
+        printResult(name, milliseconds * 1e6 / Notifications, "ns/notify");
+        printResult(name + " allocations", allocations, "allocs/notify", 2);
+    }
+}
+
+// 多个线程同时同步通知同一个事件. 快照模式的每次通知要在 SnapshotCell 上登记读者, 单个计数时所有通知线程争用
+// 同一条缓存行; 以分条之前的单计数实现作为对照, 同时给出锁模式与快照模式的 notify
+void benchConcurrentNotify()
+{
+    constexpr size_t NotificationsPerThread = 500000;
+    const size_t notifierCount = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    using Snapshot = std::vector<int>;
+
+    // 改为分条计数之前的 SnapshotCell::load, 作为对照
+    struct SingleCounterCell
+    {
+        ~SingleCounterCell()
+        {
+            delete current.load();
+        }
+
+        std::shared_ptr<const Snapshot> load() const
+        {
+            std::atomic<uint32_t>& count = readers[epoch.load() & 1].count;
+            count.fetch_add(1);
+            std::shared_ptr<const Snapshot> snapshot;
+            if (const auto* stored = current.load())
+                snapshot = *stored;
+            count.fetch_sub(1, std::memory_order_release);
+            return snapshot;
+        }
+
+        void store(std::shared_ptr<const Snapshot> snapshot)
+        {
+            const auto* previous = current.exchange(new std::shared_ptr<const Snapshot>(std::move(snapshot)));
+            for (int round = 0; round < 2 && previous != nullptr; ++round)
+            {
+                const uint64_t flipped = epoch.fetch_add(1);
+                while (readers[flipped & 1].count.load(std::memory_order_acquire) != 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            delete previous;
+        }
+
+        struct alignas(64) ReaderCount
+        {
+            std::atomic<uint32_t> count{0};
+        };
+
+        std::atomic<const std::shared_ptr<const Snapshot>*> current{nullptr};
+        std::atomic<uint64_t> epoch{0};
+        mutable std::array<ReaderCount, 2> readers{};
+    };
+
+    printSection("Notify from " + std::to_string(notifierCount) + " threads, " +
+                 std::to_string(NotificationsPerThread) + " notifications each");
+    auto run = [notifierCount](const std::string& name, auto&& notifyOnce)
+    {
+        std::atomic<size_t> checksum{0};
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> notifiers;
+        for (size_t t = 0; t < notifierCount; ++t)
+        {
+            notifiers.emplace_back(
+                [&]()
+                {
+                    size_t local = 0;
+                    for (size_t i = 0; i < NotificationsPerThread; ++i)
+                    {
+                        local += notifyOnce(i);
+                    }
+                    checksum.fetch_add(local, std::memory_order_relaxed);
+                });
+        }
+        for (auto& notifier : notifiers)
+        {
+            notifier.join();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printResult(name, elapsed / NotificationsPerThread, "ns/notify");
+    };
+
+    SingleCounterCell single;
+    single.store(std::make_shared<const Snapshot>(4, 1));
+    run("snapshot load, single reader count", [&single](size_t) { return single.load()->size(); });
+
+    comm::SnapshotCell<Snapshot> striped;
+    striped.store(std::make_shared<const Snapshot>(4, 1));
+    run("snapshot load, striped reader counts", [&striped](size_t) { return striped.load()->size(); });
+
+    for (auto notifyMode : {comm::NotifyMode::Locked, comm::NotifyMode::Snapshot})
+    {
+        auto event = std::make_shared<comm::EventSync<int>>(notifyMode);
+        std::vector<comm::EventSync<int>::SubscriptionPtr> subscriptions;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            subscriptions.push_back(event->subscribe([](int) {}));
+        }
+        const std::string name = notifyMode == comm::NotifyMode::Locked ? "NotifyMode::Locked" : "NotifyMode::Snapshot";
+        run(name + " notify",
+            [&event](size_t i)
+            {
+                event->notify(static_cast<int>(i));
+                return size_t{1};
+            });
+    }
+}
+
+// 大参数异步通知多个订阅者: 逐个 listener 派发与扇出派发的入队, 分配与参数复制开销
+void benchDispatchModes()
+{
+    constexpr size_t Subscribers = 50;
+    constexpr size_t Notifications = 20000;
+
+    printSection("Dispatch std::vector<int>(1024) to " + std::to_string(Subscribers) + " subscribers, " +
+                 std::to_string(Notifications) + " notifications");
+    for (auto dispatchMode : {comm::DispatchMode::PerListener, comm::DispatchMode::FanOut})
+    {
+        comm::ThreadPoolInvokeStrategy strategy(ThreadCount);
+        comm::Event<std::vector<int>> event(strategy, comm::NotifyMode::Snapshot, dispatchMode);
+        std::atomic<size_t> received{0};
+        std::vector<comm::Event<std::vector<int>>::SubscriptionPtr> subscriptions;
+        for (size_t i = 0; i < Subscribers; ++i)
+        {
+            subscriptions.push_back(event.subscribe([&received](const std::vector<int>& values)
+                                                    { received.fetch_add(values.size() > 0, std::memory_order_release); }));
+        }
+        const std::vector<int> payload(1024, 1);
+        const size_t before = g_allocationCount.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < Notifications; ++i)
+        {
+            event.notify(payload);
+        }
+        waitUntil(received, Subscribers * Notifications);
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const double allocations = static_cast<double>(g_allocationCount.load() - before) / Notifications;
+        const std::string name =
+            dispatchMode == comm::DispatchMode::PerListener ? "DispatchMode::PerListener" : "DispatchMode::FanOut";
+        printResult(name, elapsed / Notifications, "ns/notify");
+        printResult(name + " allocations", allocations, "allocs/notify", 2);
+    }
+}
+
+// 多核读取 Attribute::value(), 同时有一个写者每 10us 更新一次. 读写锁的读者计数在核之间来回传递,
+// 原子与 seqlock 路径的读者只读共享内存
+void benchAttributeReads()
+{
+    constexpr size_t ReadsPerThread = 2000000;
+    const size_t readerCount = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    struct Pair
+    {
+        int64_t first = 0;
+        int64_t second = 0;
+
+        bool operator==(const Pair&) const = default;
+    };
+
+    // 改为 ValueCell 之前 value() 的实现, 作为对照
+    struct SharedMutexValue
+    {
+        int value() const
+        {
+            std::shared_lock lock(mutex);
+            return stored;
+        }
+
+        void setValue(int value)
+        {
+            std::unique_lock lock(mutex);
+            stored = value;
+        }
+
+        mutable std::shared_mutex mutex;
+        int stored = 0;
+    };
+
+    printSection("Attribute::value() from " + std::to_string(readerCount) + " threads, " +
+                 std::to_string(ReadsPerThread) + " reads each, one writer");
+    auto run = [readerCount](const std::string& name, auto& attribute, auto makeValue)
+    {
+        std::atomic<bool> done{false};
+        std::thread writer(
+            [&]()
+            {
+                for (int i = 0; !done.load(std::memory_order_relaxed); ++i)
+                {
+                    attribute.setValue(makeValue(i));
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                }
+            });
+        std::atomic<size_t> checksum{0};
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> readers;
+        for (size_t t = 0; t < readerCount; ++t)
+        {
+            readers.emplace_back(
+                [&]()
+                {
+                    size_t local = 0;
+                    for (size_t i = 0; i < ReadsPerThread; ++i)
+                    {
+                        const auto value = attribute.value();
+                        unsigned char firstByte;
+                        std::memcpy(&firstByte, &value, 1);
+                        local += firstByte;
+                    }
+                    checksum.fetch_add(local, std::memory_order_relaxed);
+                });
+        }
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        done = true;
+        writer.join();
+        printResult(name, elapsed / ReadsPerThread, "ns/read");
+    };
+
+    SharedMutexValue locked;
+    run("std::shared_mutex int", locked, [](int i) { return i; });
+
+    comm::AttributeSync<int> atomicInt;
+    run("AttributeSync<int> (std::atomic)", atomicInt, [](int i) { return i; });
+
+    comm::AttributeSync<Pair> seqlockPair;
+    run("AttributeSync<Pair> (seqlock)", seqlockPair, [](int i) { return Pair{i, -i}; });
+}
+}  // namespace
+
+namespace
+{
+// 所有替换的 new/delete 都经由这两个函数, 分配一律计数, 各重载的分配与释放成对匹配: MSVC 没有 aligned_alloc,
+// 一律使用 _aligned_malloc/_aligned_free; 其它平台使用 malloc/aligned_alloc, 两者都由 free 释放.
+// 不内联: 内联后编译器会在调用点看到 free 作用于 operator new 的返回值, 误报 -Wmismatched-new-delete
+BENCH_NOINLINE void* countedAllocate(std::size_t size, std::size_t alignment)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+#ifdef _MSC_VER
+    void* ptr = _aligned_malloc(size, std::max(alignment, alignof(std::max_align_t)));
+#else
+    void* ptr = alignment <= alignof(std::max_align_t)
+                    ? std::malloc(size)
+                    : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+BENCH_NOINLINE void countedFree(void* ptr) noexcept
+{
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    countedFree(ptr);
+}
+
+// 用法: bench_threadpool [--max-elements N], N 默认 1e7, 最大可设为 1e9 (需要约 16GB 内存)
+int main(int argc, char* argv[])
+{
+    size_t maxElements = 10000000;
+    std::string filter;
+    std::string jsonPath;
+    bool listOnly = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--max-elements" && i + 1 < argc)
+            maxElements = std::stoull(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--label" && i + 1 < argc)
+            g_report.setLabel(argv[++i]);
+        else if (arg == "--list")
+            listOnly = true;
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--filter <substring>] [--json <path>] [--label <text>] [--max-elements <n>] [--list]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::pair<std::string, std::function<void()>>> benchmarks = {
+        {"throughput", benchEmptyTaskThroughput},
+        {"submit-latency", benchSubmitToStartLatency},
+        {"fan-out", benchFanOutFanIn},
+        {"producer-contention", benchProducerContention},
+        {"thread-scaling", benchThreadScaling},
+        {"mixed-sizes", benchMixedTaskSizes},
+        {"allocations", benchAllocationsPerTask},
+        {"priority-latency", benchPriorityLatency},
+        {"parallel-algorithms", [maxElements]() { benchParallelAlgorithms(maxElements); }},
+        {"affinity-bandwidth", benchAffinityBandwidth},
+        {"wakeup-latency", benchWakeupLatency},
+        {"bounded-burst", benchBoundedBurst},
+        {"invoke-strategies", benchInvokeStrategies},
+        {"timing-overhead", benchTimingOverhead},
+        {"keyed-tasks", benchKeyedTasks},
+        {"timers", benchTimers},
+        {"notify-modes", benchNotifyModes},
+        {"concurrent-notify", benchConcurrentNotify},
+        {"dispatch-modes", benchDispatchModes},
+        {"attribute-reads", benchAttributeReads},
+    };
+    for (const auto& [name, run] : benchmarks)
+    {
+        if (listOnly)
+            std::cout << name << std::endl;
+        else if (filter.empty() || name.find(filter) != std::string::npos)
+            run();
+    }
+
+    if (!jsonPath.empty() && !listOnly)
+    {
+        if (!g_report.writeJson(jsonPath))
+        {
+            std::cerr << "Failed to write " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << jsonPath << std::endl;
+    }
+    return 0;
+}
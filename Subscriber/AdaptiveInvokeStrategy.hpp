@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "Subscriber.hpp"
+
+namespace comm
+{
+
+// 按 listener 的实测耗时选择执行方式: 平均耗时低于阈值的 listener 在通知线程上直接执行, 省去排队与唤醒;
+// 其余的交给 dispatcher (通常是 ThreadPoolInvokeStrategy). 两种方式下都会测量耗时, listener 变慢后自动改为派发.
+// 首次通知时耗时未知, 先派发. 没有 listener 标识的 invoke 总是派发.
+class AdaptiveInvokeStrategy : public IInvokeStrategy
+{
+public:
+    explicit AdaptiveInvokeStrategy(IInvokeStrategy& dispatcher,
+                                    std::chrono::nanoseconds inlineThreshold = std::chrono::microseconds(2))
+        : m_dispatcher(dispatcher)
+        , m_inlineThreshold(static_cast<uint64_t>(inlineThreshold.count()))
+        , m_costs(std::make_shared<CostTable>())
+    {
+    }
+
+    void invoke(std::function<void()> func) override
+    {
+        m_dispatchedCount++;
+        m_dispatcher.invoke(std::move(func));
+    }
+
+    void invokeFor(uint64_t listenerId, std::function<void()> func) override
+    {
+        CostSlot& slot = m_costs->slotOf(listenerId);
+        const uint64_t average = slot.averageOf(listenerId);
+        if (average != Unknown && average - 1 < m_inlineThreshold)
+        {
+            m_inlinedCount++;
+            measure(slot, listenerId, func);
+            return;
+        }
+        m_dispatchedCount++;
+        // 派发的任务持有耗时表, 在本策略析构之后才执行也不会访问失效的内存
+        m_dispatcher.invokeFor(listenerId,
+                               [costs = m_costs, &slot, listenerId, func = std::move(func)]() mutable
+                               { measure(slot, listenerId, func); });
+    }
+
+    size_t getInlinedCount() const
+    {
+        return m_inlinedCount.load();
+    }
+
+    size_t getDispatchedCount() const
+    {
+        return m_dispatchedCount.load();
+    }
+
+private:
+    // 表中存放平均耗时 + 1 纳秒, 0 表示还没有测量过
+    static constexpr uint64_t Unknown = 0;
+    static constexpr unsigned CostSlotBits = 10;
+
+    // 槽位记录最近测量它的 listener 标识, 标识不符时视为未测量. 标识不会复用, 新订阅的 listener 不会继承
+    // 已退订 listener 的耗时; 散列冲突的 listener 轮流占用槽位, 只影响选择的准确性
+    struct CostSlot
+    {
+        uint64_t averageOf(uint64_t listenerId) const
+        {
+            if (owner.load(std::memory_order_relaxed) != listenerId)
+                return Unknown;
+            return cost.load(std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> owner{0};
+        std::atomic<uint64_t> cost{Unknown};
+    };
+
+    // 每个策略实例一张固定大小的表, 不随订阅增删而增长
+    struct CostTable
+    {
+        CostSlot& slotOf(uint64_t listenerId)
+        {
+            return slots[static_cast<size_t>(listenerId * 0x9E3779B97F4A7C15ull >> (64 - CostSlotBits))];
+        }
+
+        std::array<CostSlot, size_t{1} << CostSlotBits> slots{};
+    };
+
+    // 执行并按 1/8 权重更新指数移动平均耗时, 并发更新时丢失一次样本无关紧要
+    static void measure(CostSlot& slot, uint64_t listenerId, std::function<void()>& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        runListener(func);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                                  start);
+        const uint64_t sample = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+        const uint64_t stored = slot.averageOf(listenerId);
+        const uint64_t average = stored == Unknown ? sample : stored - 1 - (stored - 1) / 8 + sample / 8;
+        slot.cost.store(average + 1, std::memory_order_relaxed);
+        slot.owner.store(listenerId, std::memory_order_relaxed);
+    }
+
+    IInvokeStrategy& m_dispatcher;
+    const uint64_t m_inlineThreshold;
+    const std::shared_ptr<CostTable> m_costs;
+    std::atomic<size_t> m_inlinedCount{0};
+    std::atomic<size_t> m_dispatchedCount{0};
+};
+
+}  // namespace comm
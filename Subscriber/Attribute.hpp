@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include "Subscriber.hpp"
+#include "ValueCell.hpp"
 
 namespace comm
 {
@@ -13,27 +14,25 @@ public:
     using Interface = Subscribable<ValueType>;
     using Sync = AttributeSync<ValueType>;
 
-    AttributeSync(const ValueType& defaultValue = ValueType(), bool notifyIfNotChanged = false)
-        : m_value(defaultValue)
+    AttributeSync(const ValueType& defaultValue = ValueType(), bool notifyIfNotChanged = false,
+                  NotifyMode mode = NotifyMode::Locked)
+        : Interface(mode)
+        , m_value(defaultValue)
         , m_notifyIfNotChanged(notifyIfNotChanged)
     {
     }
 
     ValueType value() const
     {
-        std::shared_lock lock(m_mutex);
-        return m_value;
+        return m_value.load();
     }
 
     bool setValue(const ValueType& value)
     {
-        std::unique_lock lock(m_mutex);
-        if (m_value == value && !m_notifyIfNotChanged)
+        if (!m_value.store(value, m_notifyIfNotChanged))
         {
             return false;
         }
-        m_value = value;
-        lock.unlock();
         notify();
         return true;
     }
@@ -45,8 +44,7 @@ protected:
     }
 
 private:
-    mutable std::shared_mutex m_mutex;
-    ValueType m_value;
+    ValueCell<ValueType> m_value;
     bool m_notifyIfNotChanged;
 };
 
@@ -57,8 +55,10 @@ public:
     using Interface = Subscribable<ValueType>;
     using Sync = AttributeSync<ValueType>;
 
-    Attribute(IInvokeStrategy& strategy, const ValueType& defaultValue = ValueType(), bool notifyIfNotChanged = false)
-        : m_strategy(strategy)
+    Attribute(IInvokeStrategy& strategy, const ValueType& defaultValue = ValueType(), bool notifyIfNotChanged = false,
+              NotifyMode mode = NotifyMode::Locked, DispatchMode dispatchMode = DispatchMode::PerListener)
+        : Interface(mode, dispatchMode)
+        , m_strategy(strategy)
         , m_value(defaultValue)
         , m_notifyIfNotChanged(notifyIfNotChanged)
     {
@@ -66,19 +66,15 @@ public:
 
     ValueType value() const
     {
-        std::shared_lock lock(m_mutex);
-        return m_value;
+        return m_value.load();
     }
 
     bool setValue(const ValueType& value)
     {
-        std::unique_lock lock(m_mutex);
-        if (m_value == value && !m_notifyIfNotChanged)
+        if (!m_value.store(value, m_notifyIfNotChanged))
         {
             return false;
         }
-        m_value = value;
-        lock.unlock();
         notify();
         return true;
     }
@@ -91,8 +87,7 @@ protected:
 
 private:
     IInvokeStrategy& m_strategy;
-    mutable std::shared_mutex m_mutex;
-    ValueType m_value;
+    ValueCell<ValueType> m_value;
     bool m_notifyIfNotChanged;
 };
 
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include "Subscriber.hpp"
+
+namespace comm
+{
+
+// 在协程中等待 Event/Attribute 的下一次通知: co_await nextNotification(event).
+// 挂起期间不占用线程, 只持有一个一次性订阅; 协程在发出通知的线程上恢复 (Event 为调用策略的线程),
+// 需要切换到线程池时再 co_await pool.schedule(). 没有参数时返回 void, 一个参数时返回该值, 多个参数时返回 tuple.
+template<typename... Arguments>
+class NotificationAwaiter
+{
+public:
+    explicit NotificationAwaiter(Subscribable<Arguments...>& subscribable)
+        : m_subscribable(subscribable)
+        , m_state(std::make_shared<State>())
+    {
+    }
+
+    NotificationAwaiter(NotificationAwaiter&&) = default;
+
+    ~NotificationAwaiter()
+    {
+        // 协程在等待期间被销毁时撤销订阅, 打破订阅与状态之间的循环引用
+        if (m_state)
+            m_state->cancel();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // 订阅后通知可能立即在其它线程恢复协程并销毁本对象, 之后只能访问局部变量
+        auto state = m_state;
+        state->m_handle = handle;
+        auto subscription = m_subscribable.subscribe([state](const Arguments&... arguments)
+                                                     { state->fire(arguments...); });
+        std::lock_guard<std::mutex> lock(state->m_mutex);
+        if (!state->m_fired)
+            state->m_subscription = std::move(subscription);
+    }
+
+    auto await_resume()
+    {
+        if constexpr (sizeof...(Arguments) == 0)
+            return;
+        else if constexpr (sizeof...(Arguments) == 1)
+            return std::get<0>(std::move(*m_state->m_values));
+        else
+            return std::move(*m_state->m_values);
+    }
+
+private:
+    using SubscriptionPtr = typename Subscribable<Arguments...>::SubscriptionPtr;
+
+    struct State
+    {
+        void fire(const Arguments&... arguments)
+        {
+            if (m_fired.exchange(true))
+                return;
+            m_values.emplace(arguments...);
+            SubscriptionPtr subscription;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                subscription = std::move(m_subscription);
+            }
+            if (subscription)
+                subscription->unsubscribe();
+            m_handle.resume();
+        }
+
+        void cancel()
+        {
+            SubscriptionPtr subscription;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                subscription = std::move(m_subscription);
+            }
+        }
+
+        std::mutex m_mutex;
+        std::atomic<bool> m_fired{false};
+        std::coroutine_handle<> m_handle;
+        SubscriptionPtr m_subscription;
+        std::optional<std::tuple<Arguments...>> m_values;
+    };
+
+    Subscribable<Arguments...>& m_subscribable;
+    std::shared_ptr<State> m_state;
+};
+
+template<typename... Arguments>
+NotificationAwaiter<Arguments...> nextNotification(Subscribable<Arguments...>& subscribable)
+{
+    return NotificationAwaiter<Arguments...>(subscribable);
+}
+
+}  // namespace comm
@@ -12,7 +12,10 @@ public:
     using Interface = Subscribable<Arguments...>;
     using Sync = EventSync<Arguments...>;
 
-    EventSync() = default;
+    explicit EventSync(NotifyMode mode = NotifyMode::Locked)
+        : Interface(mode)
+    {
+    }
 
     void notify(const Arguments&... arguments) const
     {
@@ -27,8 +30,10 @@ public:
     using Interface = Subscribable<Arguments...>;
     using Sync = EventSync<Arguments...>;
 
-    explicit Event(IInvokeStrategy& strategy)
-        : m_strategy(strategy)
+    explicit Event(IInvokeStrategy& strategy, NotifyMode mode = NotifyMode::Locked,
+                   DispatchMode dispatchMode = DispatchMode::PerListener)
+        : Interface(mode, dispatchMode)
+        , m_strategy(strategy)
     {
     }
 
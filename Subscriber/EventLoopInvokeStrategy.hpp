@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "RingDeque.hpp"
+#include "Subscriber.hpp"
+#include "UniqueTask.hpp"
+
+namespace comm
+{
+
+// 单线程事件循环: invoke 可以在任意线程调用, listener 只在驱动循环的线程 (通常是 UI 或主线程) 上执行,
+// 由该线程周期性调用 runOnce() 或 runFor(). listener 之间天然串行, 不需要额外同步.
+class EventLoopInvokeStrategy : public IInvokeStrategy
+{
+public:
+    void invoke(std::function<void()> func) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(UniqueTask(std::move(func)));
+        }
+        m_condition.notify_one();
+    }
+
+    // 执行调用时已排队的所有 listener, 不等待. 执行期间新提交的 listener 留到下一轮, 避免一直无法返回
+    size_t runOnce()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::swap(m_queue, m_running);
+        }
+        size_t count = 0;
+        while (!m_running.empty())
+        {
+            UniqueTask task = std::move(m_running.front());
+            m_running.pop_front();
+            runListener(task);
+            ++count;
+        }
+        return count;
+    }
+
+    // 在 duration 内持续执行 listener, 没有 listener 时休眠等待, 到时或 interrupt() 后返回执行的数量
+    template<typename Rep, typename Period>
+    size_t runFor(std::chrono::duration<Rep, Period> duration)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + duration;
+        size_t count = 0;
+        while (true)
+        {
+            count += runOnce();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const bool ready = m_condition.wait_until(lock, deadline,
+                                                      [this] { return m_interrupted || !m_queue.empty(); });
+            if (m_interrupted)
+            {
+                m_interrupted = false;
+                return count;
+            }
+            if (!ready || std::chrono::steady_clock::now() >= deadline)
+                return count;
+        }
+    }
+
+    // 让正在 runFor 中等待的循环尽快返回
+    void interrupt()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_interrupted = true;
+        }
+        m_condition.notify_one();
+    }
+
+    size_t getQueueSize() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    RingDeque<UniqueTask> m_queue;
+    RingDeque<UniqueTask> m_running;  // 只由驱动线程访问, 与 m_queue 交换以复用缓冲区
+    bool m_interrupted = false;
+};
+
+}  // namespace comm
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+
+#include "Subscriber.hpp"
+
+namespace comm
+{
+
+// 在 notify 的调用线程上直接执行 listener, 没有排队与线程切换的开销, 适合很廉价的 listener.
+// listener 执行完之前 notify 不会返回, 耗时的 listener 会拖慢通知方.
+class InlineInvokeStrategy : public IInvokeStrategy
+{
+public:
+    void invoke(std::function<void()> func) override
+    {
+        runListener(func);
+    }
+};
+
+}  // namespace comm
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace comm
+{
+
+// 按代号索引的槽位表: 元素连续存放在 dense 数组中便于遍历, 通过稳定的 Key 在 O(1) 时间内插入与删除.
+// 删除时把最后一个元素移到空出的位置, 因此遍历顺序不保持插入顺序. Key 中的代号防止旧 Key 访问到复用后的槽位
+template<typename T>
+class SlotMap
+{
+public:
+    struct Key
+    {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    Key insert(T value)
+    {
+        uint32_t index = m_freeHead;
+        if (index != Nil)
+        {
+            m_freeHead = m_slots[index].position;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot{});
+        }
+        Slot& slot = m_slots[index];
+        slot.position = static_cast<uint32_t>(m_values.size());
+        m_values.push_back(std::move(value));
+        m_owners.push_back(index);
+        return Key{index, slot.generation};
+    }
+
+    bool erase(Key key)
+    {
+        if (!contains(key))
+            return false;
+        Slot& slot = m_slots[key.index];
+        const uint32_t position = slot.position;
+        const uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+        if (position != last)
+        {
+            m_values[position] = std::move(m_values[last]);
+            m_owners[position] = m_owners[last];
+            m_slots[m_owners[position]].position = position;
+        }
+        m_values.pop_back();
+        m_owners.pop_back();
+
+        slot.generation++;
+        slot.position = m_freeHead;
+        m_freeHead = key.index;
+        return true;
+    }
+
+    bool contains(Key key) const
+    {
+        return key.index < m_slots.size() && m_slots[key.index].generation == key.generation;
+    }
+
+    T* find(Key key)
+    {
+        return contains(key) ? &m_values[m_slots[key.index].position] : nullptr;
+    }
+
+    const std::vector<T>& values() const
+    {
+        return m_values;
+    }
+
+    size_t size() const
+    {
+        return m_values.size();
+    }
+
+    bool empty() const
+    {
+        return m_values.empty();
+    }
+
+private:
+    static constexpr uint32_t Nil = std::numeric_limits<uint32_t>::max();
+
+    // 使用中的槽位 position 为元素在 dense 数组中的下标, 空闲槽位借用 position 串成空闲链表
+    struct Slot
+    {
+        uint32_t position = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_owners;  // dense 下标 -> 槽位下标
+    std::vector<Slot> m_slots;
+    uint32_t m_freeHead = Nil;
+};
+
+}  // namespace comm
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace comm
+{
+
+// 存放一个不可变快照的 shared_ptr, 读取不加锁: 读者只在复制 shared_ptr 的瞬间登记到按纪元奇偶分开的两个计数上,
+// 写者替换指针后两次翻转纪元, 每次等待上一纪元的读者离开, 之后旧的 shared_ptr 不会再被读到, 可以安全释放.
+// 读者持有返回的 shared_ptr 期间快照一直有效, 写者不等待快照的使用者, 只等待极短的复制窗口.
+// 每个纪元的计数按线程分成 ReaderStripes 条缓存行, 多个线程同时通知时不争用同一个计数; 写者等待该纪元的所有分条.
+// 只支持单个写者, 写操作由调用方加锁
+template<typename T>
+class SnapshotCell
+{
+public:
+    SnapshotCell() = default;
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    ~SnapshotCell()
+    {
+        delete m_current.load();
+    }
+
+    std::shared_ptr<const T> load() const
+    {
+        std::atomic<uint32_t>& readers = m_readers[(m_epoch.load() & 1) * ReaderStripes + readerStripe()].count;
+        readers.fetch_add(1);
+        std::shared_ptr<const T> snapshot;
+        if (const auto* current = m_current.load())
+            snapshot = *current;
+        readers.fetch_sub(1, std::memory_order_release);
+        return snapshot;
+    }
+
+    void store(std::shared_ptr<const T> snapshot)
+    {
+        auto* next = snapshot ? new std::shared_ptr<const T>(std::move(snapshot)) : nullptr;
+        const auto* previous = m_current.exchange(next);
+        if (previous == nullptr)
+            return;
+        // 读到过旧纪元的读者可能登记在任一计数上, 两个计数都要等待一次; 翻转后新读者登记在另一个计数上, 等待有界
+        for (int round = 0; round < 2; ++round)
+        {
+            const uint64_t epoch = m_epoch.fetch_add(1);
+            for (size_t stripe = 0; stripe < ReaderStripes; ++stripe)
+            {
+                while (m_readers[(epoch & 1) * ReaderStripes + stripe].count.load(std::memory_order_acquire) != 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        delete previous;
+    }
+
+private:
+    static constexpr size_t ReaderStripes = 16;
+
+    struct alignas(64) ReaderCount
+    {
+        std::atomic<uint32_t> count{0};
+    };
+
+    // 线程首次读取时按顺序分配分条, 同时活跃的线程不超过 ReaderStripes 个时互不共享
+    static size_t readerStripe()
+    {
+        static std::atomic<size_t> next{0};
+        static thread_local const size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % ReaderStripes;
+        return stripe;
+    }
+
+    std::atomic<const std::shared_ptr<const T>*> m_current{nullptr};
+    std::atomic<uint64_t> m_epoch{0};
+    mutable std::array<ReaderCount, 2 * ReaderStripes> m_readers{};
+};
+
+}  // namespace comm
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <functional>
-#include <list>
+#include <iostream>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "SlotMap.hpp"
+#include "SnapshotCell.hpp"
+
 namespace comm
 {
 
@@ -16,6 +23,65 @@ class IInvokeStrategy
 public:
     virtual ~IInvokeStrategy() = default;
     virtual void invoke(std::function<void()> func) = 0;
+
+    // 带 listener 标识的调用, 需要按 listener 统计的策略 (如 AdaptiveInvokeStrategy) 重写, 默认等同于 invoke.
+    // 标识在进程内唯一且不会复用, 退订后新订阅的 listener 不会得到旧 listener 的标识
+    virtual void invokeFor(uint64_t /*listenerId*/, std::function<void()> func)
+    {
+        invoke(std::move(func));
+    }
+
+protected:
+    template<typename... Arguments>
+    friend class Subscribable;
+
+    // 所有 Subscribable 共用的标识序列, 不同参数类型的事件共享同一个策略时标识也不会重复
+    static uint64_t nextListenerId()
+    {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // listener 抛出的异常只记录, 不影响其它 listener 和调用策略自身
+    template<typename Func>
+    static void runListener(Func& func)
+    {
+        try
+        {
+            func();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Exception in invoked listener: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "Unknown exception in invoked listener" << std::endl;
+        }
+    }
+};
+
+// 订阅表的并发方式
+enum class NotifyMode
+{
+    // 通知时持读锁收集活跃订阅, 订阅与退订开销最小, 适合订阅频繁变动的对象
+    Locked,
+    // 订阅与退订时复制并发布不可变的订阅快照 (写时复制), 通知只原子加载当前快照, 不加锁也不分配内存,
+    // 适合通知远多于订阅变动的对象. 退订后正在进行的通知仍可能持有旧快照, 由订阅的活跃标志跳过
+    Snapshot,
+};
+
+// notifyAsync 把 listener 交给调用策略的方式
+enum class DispatchMode
+{
+    // 每个 listener 一个任务, 各自复制一份参数. listener 之间并行度最高, 也能按 listener 选择执行方式 (invokeFor)
+    PerListener,
+    // 每次通知只把参数复制一次到共享的不可变载荷, 每 FanOutChunkSize 个 listener 合为一个任务依次调用,
+    // 订阅者多或参数复制昂贵 (如大的 std::vector) 时省去逐个 listener 的入队, 分配与复制
+    FanOut,
+    // 合并投递: 每个 listener 最多有一个待投递的通知, 新的通知覆盖尚未投递的参数, listener 总是收到最新的值.
+    // 同一 listener 的投递依次执行, 更新快于 listener 处理时队列长度不超过订阅数, 也不会在过期的值上耗费时间
+    Conflate,
 };
 
 template<typename... Arguments>
@@ -27,7 +93,14 @@ public:
     class Subscription;
     using SubscriptionPtr = std::shared_ptr<Subscription>;
 
-    Subscribable() = default;
+    static constexpr size_t FanOutChunkSize = 64;
+
+    explicit Subscribable(NotifyMode mode = NotifyMode::Locked, DispatchMode dispatchMode = DispatchMode::PerListener)
+        : m_registry(std::make_shared<Registry>(mode))
+        , m_dispatchMode(dispatchMode)
+    {
+    }
+
     virtual ~Subscribable() = default;
 
     Subscribable(const Subscribable&) = delete;
@@ -35,109 +108,251 @@ public:
 
     [[nodiscard]] SubscriptionPtr subscribe(Listener listener);
 
+    NotifyMode getNotifyMode() const
+    {
+        return m_registry->m_notifyMode;
+    }
+
+    DispatchMode getDispatchMode() const
+    {
+        return m_dispatchMode;
+    }
+
+    size_t getSubscriptionCount() const
+    {
+        std::shared_lock lock(m_registry->m_mutex);
+        return m_registry->m_listeners.size();
+    }
+
 protected:
     void notifySync(const Arguments&... arguments) const;
     void notifyAsync(IInvokeStrategy& strategy, const Arguments&... arguments) const;
 
+private:
+    // listener 与活跃标志. 由 Subscription 与订阅表共同持有, 通知过程中退订不会使正在使用的 listener 失效
+    struct ListenerState
+    {
+        explicit ListenerState(Listener listener)
+            : m_listener(std::move(listener))
+            , m_id(IInvokeStrategy::nextListenerId())
+        {
+        }
+
+        void invoke(const Arguments&... args)
+        {
+            if (m_isActive)
+            {
+                m_listener(args...);
+            }
+        }
+
+        // 合并投递: 记录最新的参数, 返回 true 表示当前没有投递任务, 调用方需要调度一个
+        bool offer(std::shared_ptr<const std::tuple<Arguments...>> payload)
+        {
+            std::lock_guard lock(m_pendingMutex);
+            m_pending = std::move(payload);
+            return !std::exchange(m_deliveryScheduled, true);
+        }
+
+        std::shared_ptr<const std::tuple<Arguments...>> takePending()
+        {
+            std::lock_guard lock(m_pendingMutex);
+            return std::move(m_pending);
+        }
+
+        // 投递任务结束时调用, 返回 true 表示期间又有新的通知, 需要再调度一次
+        bool finishDelivery()
+        {
+            std::lock_guard lock(m_pendingMutex);
+            m_deliveryScheduled = m_pending != nullptr;
+            return m_deliveryScheduled;
+        }
+
+        void cancelDelivery()
+        {
+            std::lock_guard lock(m_pendingMutex);
+            m_pending.reset();
+            m_deliveryScheduled = false;
+        }
+
+        Listener m_listener;
+        const uint64_t m_id;
+        std::atomic<bool> m_isActive{true};
+
+        std::mutex m_pendingMutex;
+        std::shared_ptr<const std::tuple<Arguments...>> m_pending;
+        bool m_deliveryScheduled = false;
+    };
+
+    using ListenerPtr = std::shared_ptr<ListenerState>;
+    using Snapshot = std::vector<ListenerPtr>;
+    using Key = typename SlotMap<ListenerPtr>::Key;
+
+    // 订阅表: 活跃订阅连续存放在槽位表中, 退订 O(1). 由 Subscribable 独占, Subscription 只持有 weak_ptr,
+    // 因此 Subscribable 不由 shared_ptr 管理时退订也能移除订阅
+    struct Registry
+    {
+        explicit Registry(NotifyMode mode)
+            : m_notifyMode(mode)
+        {
+        }
+
+        // 在写锁下调用: 快照模式发布当前订阅的不可变副本
+        void publish()
+        {
+            if (m_notifyMode == NotifyMode::Snapshot)
+                m_snapshot.store(std::make_shared<const Snapshot>(m_listeners.values()));
+        }
+
+        void remove(Key key)
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_listeners.erase(key))
+                publish();
+        }
+
+        // 通知时使用的订阅列表. 快照模式直接返回当前快照, 否则在读锁下复制一份, 使 listener 在锁外执行
+        std::shared_ptr<const Snapshot> listeners() const
+        {
+            if (m_notifyMode == NotifyMode::Snapshot)
+                return m_snapshot.load();
+            std::shared_lock lock(m_mutex);
+            return m_listeners.empty() ? nullptr : std::make_shared<const Snapshot>(m_listeners.values());
+        }
+
+        const NotifyMode m_notifyMode;
+        mutable std::shared_mutex m_mutex;
+        SlotMap<ListenerPtr> m_listeners;
+        SnapshotCell<Snapshot> m_snapshot;
+    };
+
 public:  // 将 Subscription 类移到 public 部分
     class Subscription : public std::enable_shared_from_this<Subscription>
     {
     public:
-        explicit Subscription(Listener listener, std::weak_ptr<Subscribable> parent);
+        Subscription(ListenerPtr state, std::weak_ptr<Registry> registry, Key key);
         ~Subscription();
 
         void invoke(const Arguments&... args);
         void unsubscribe();
 
     private:
-        Listener m_listener;
-        std::weak_ptr<Subscribable> m_parent;
-        std::atomic<bool> m_isActive{true};
+        ListenerPtr m_state;
+        std::weak_ptr<Registry> m_registry;
+        const Key m_key;
     };
 
 private:
-    void removeSubscription(const Subscription* sub);
+    static void scheduleDelivery(IInvokeStrategy& strategy, const ListenerPtr& state);
 
-    mutable std::shared_mutex m_mutex;
-    std::list<std::weak_ptr<Subscription>> m_subscriptions;
+    const std::shared_ptr<Registry> m_registry;
+    const DispatchMode m_dispatchMode;
 };
 
 // Implementation
 template<typename... Arguments>
 typename Subscribable<Arguments...>::SubscriptionPtr Subscribable<Arguments...>::subscribe(Listener listener)
 {
-    auto subscription = std::make_shared<Subscription>(std::move(listener), this->weak_from_this());
+    auto state = std::make_shared<ListenerState>(std::move(listener));
+    Key key;
     {
-        std::unique_lock lock(m_mutex);
-        m_subscriptions.push_back(subscription);
+        std::unique_lock lock(m_registry->m_mutex);
+        key = m_registry->m_listeners.insert(state);
+        m_registry->publish();
     }
-    return subscription;
+    return std::make_shared<Subscription>(std::move(state), m_registry, key);
 }
 
 template<typename... Arguments>
 void Subscribable<Arguments...>::notifySync(const Arguments&... arguments) const
 {
-    std::vector<std::shared_ptr<Subscription>> activeSubscriptions;
+    const auto listeners = m_registry->listeners();
+    if (!listeners)
+        return;
+    for (const auto& state : *listeners)
     {
-        std::shared_lock lock(m_mutex);
-        activeSubscriptions.reserve(m_subscriptions.size());
-        for (const auto& weakSub : m_subscriptions)
-        {
-            if (auto sub = weakSub.lock())
-            {
-                activeSubscriptions.push_back(std::move(sub));
-            }
-        }
-    }
-
-    for (const auto& sub : activeSubscriptions)
-    {
-        sub->invoke(arguments...);
+        state->invoke(arguments...);
     }
 }
 
 template<typename... Arguments>
 void Subscribable<Arguments...>::notifyAsync(IInvokeStrategy& strategy, const Arguments&... arguments) const
 {
-    std::vector<std::shared_ptr<Subscription>> activeSubscriptions;
+    const auto listeners = m_registry->listeners();
+    if (!listeners)
+        return;
+    if (m_dispatchMode == DispatchMode::Conflate)
     {
-        std::shared_lock lock(m_mutex);
-        activeSubscriptions.reserve(m_subscriptions.size());
-        for (const auto& weakSub : m_subscriptions)
+        auto payload = std::make_shared<const std::tuple<Arguments...>>(arguments...);
+        for (const auto& state : *listeners)
         {
-            if (auto sub = weakSub.lock())
-            {
-                activeSubscriptions.push_back(std::move(sub));
-            }
+            if (state->offer(payload))
+                scheduleDelivery(strategy, state);
         }
+        return;
     }
-
-    for (const auto& sub : activeSubscriptions)
+    if (m_dispatchMode == DispatchMode::FanOut)
+    {
+        // 任务共享快照与载荷, listener 逐个隔离异常, 一个 listener 抛出不影响同一任务中的其它 listener
+        auto payload = std::make_shared<const std::tuple<Arguments...>>(arguments...);
+        for (size_t begin = 0; begin < listeners->size(); begin += FanOutChunkSize)
+        {
+            const size_t end = std::min(begin + FanOutChunkSize, listeners->size());
+            strategy.invoke(
+                [listeners, payload, begin, end]()
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        auto call = [&state = (*listeners)[i], &payload]()
+                        { std::apply([&state](const auto&... params) { state->invoke(params...); }, *payload); };
+                        IInvokeStrategy::runListener(call);
+                    }
+                });
+        }
+        return;
+    }
+    for (const auto& state : *listeners)
     {
-        strategy.invoke(
-            [sub, args = std::make_tuple(arguments...)]() mutable {
-                std::apply([&sub](auto&&... params) { sub->invoke(std::forward<decltype(params)>(params)...); },
+        strategy.invokeFor(
+            state->m_id, [state, args = std::make_tuple(arguments...)]() mutable {
+                std::apply([&state](auto&&... params) { state->invoke(std::forward<decltype(params)>(params)...); },
                            std::move(args));
             });
     }
 }
 
+// 每次投递一个最新的值, 之后若有新的通知再提交下一个任务, 而不是在同一任务中循环, 避免持续更新时长期占用工作线程
 template<typename... Arguments>
-void Subscribable<Arguments...>::removeSubscription(const Subscription* sub)
+void Subscribable<Arguments...>::scheduleDelivery(IInvokeStrategy& strategy, const ListenerPtr& state)
 {
-    std::unique_lock lock(m_mutex);
-    m_subscriptions.remove_if(
-        [sub](const std::weak_ptr<Subscription>& weakSub)
-        {
-            auto sharedSub = weakSub.lock();
-            return !sharedSub || sharedSub.get() == sub;
-        });
+    try
+    {
+        strategy.invokeFor(state->m_id,
+                           [&strategy, state]()
+                           {
+                               if (const auto payload = state->takePending())
+                               {
+                                   auto call = [&state, &payload]()
+                                   { std::apply([&state](const auto&... params) { state->invoke(params...); }, *payload); };
+                                   IInvokeStrategy::runListener(call);
+                               }
+                               if (state->finishDelivery())
+                                   scheduleDelivery(strategy, state);
+                           });
+    }
+    catch (...)
+    {
+        // 调用策略拒绝任务时清除待投递状态, 否则该 listener 之后的通知都不会再被调度
+        state->cancelDelivery();
+        throw;
+    }
 }
 
 template<typename... Arguments>
-Subscribable<Arguments...>::Subscription::Subscription(Listener listener, std::weak_ptr<Subscribable> parent)
-    : m_listener(std::move(listener))
-    , m_parent(std::move(parent))
+Subscribable<Arguments...>::Subscription::Subscription(ListenerPtr state, std::weak_ptr<Registry> registry, Key key)
+    : m_state(std::move(state))
+    , m_registry(std::move(registry))
+    , m_key(key)
 {
 }
 
@@ -150,21 +365,18 @@ Subscribable<Arguments...>::Subscription::~Subscription()
 template<typename... Arguments>
 void Subscribable<Arguments...>::Subscription::invoke(const Arguments&... args)
 {
-    if (m_isActive)
-    {
-        m_listener(args...);
-    }
+    m_state->invoke(args...);
 }
 
 template<typename... Arguments>
 void Subscribable<Arguments...>::Subscription::unsubscribe()
 {
     bool expected = true;
-    if (m_isActive.compare_exchange_strong(expected, false))
+    if (m_state->m_isActive.compare_exchange_strong(expected, false))
     {
-        if (auto parent = m_parent.lock())
+        if (auto registry = m_registry.lock())
         {
-            parent->removeSubscription(this);
+            registry->remove(m_key);
         }
     }
 }
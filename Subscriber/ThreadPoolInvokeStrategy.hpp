@@ -1,31 +1,47 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <functional>
-#include <future>
 #include <memory>
-#include <mutex>
-#include <queue>
+#include <stdexcept>
 #include <thread>
-#include <vector>
 
 #include "Subscriber.hpp"
+#include "TaskGroup.hpp"
+#include "ThreadPool.hpp"
 
 namespace comm
 {
 
+struct InvokeStrategyOptions
+{
+    AffinityOptions affinity;
+    WaitStrategy waitStrategy;
+
+    // 排队任务数上限, 0 表示不限制, 防止突发的 notify 让队列无限增长
+    size_t capacity = 0;
+    OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+};
+
+// 把 listener 交给 ThreadPool 执行的调用策略. 可以独占一个新建的线程池, 也可以作为已有线程池的适配器,
+// 让订阅系统与其它子系统共用同一组工作线程, 避免机器被多套线程池超额订阅.
+// 关闭操作只影响经由本策略提交的任务, 共享的线程池继续为其它使用者服务.
 class ThreadPoolInvokeStrategy : public IInvokeStrategy
 {
 public:
-    explicit ThreadPoolInvokeStrategy(size_t threadCount = std::thread::hardware_concurrency())
-        : m_running(true)
-        , m_activeThreads(0)
+    explicit ThreadPoolInvokeStrategy(size_t threadCount = std::thread::hardware_concurrency(),
+                                      const InvokeStrategyOptions& options = {})
+        : m_ownedPool(std::make_unique<ThreadPool>(threadCount, toPoolOptions(options)))
+        , m_pool(*m_ownedPool)
+        , m_group(m_pool)
+    {
+    }
+
+    explicit ThreadPoolInvokeStrategy(ThreadPool& pool)
+        : m_pool(pool)
+        , m_group(pool)
     {
-        for (size_t i = 0; i < threadCount; ++i)
-        {
-            m_threads.emplace_back(&ThreadPoolInvokeStrategy::workerThread, this);
-        }
     }
 
     ~ThreadPoolInvokeStrategy()
@@ -39,72 +55,87 @@ public:
         {
             throw std::runtime_error("ThreadPoolInvokeStrategy is shutting down");
         }
+        m_group.post([func = std::move(func)]() mutable { runListener(func); });
+    }
 
-        std::packaged_task<void()> task(std::move(func));
-        std::future<void> future = task.get_future();
+    // 执行完所有已提交的 listener 后停止
+    void shutdown()
+    {
+        m_running = false;
+        m_group.wait();
+    }
 
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            m_taskQueue.emplace(std::move(task));
-        }
-        m_condition.notify_one();
+    // 丢弃尚未开始的 listener, 等待正在执行的 listener 结束后停止, 返回丢弃的数量
+    size_t shutdownNow()
+    {
+        m_running = false;
+        if (m_ownedPool)
+            return m_ownedPool->shutdownNow();
+        return cancelPending();
     }
 
-    void shutdown()
+    // 在 timeout 内继续执行已提交的 listener, 超时后丢弃剩余的, 返回丢弃的数量
+    template<typename Rep, typename Period>
+    size_t shutdown(std::chrono::duration<Rep, Period> timeout)
     {
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            m_running = false;
-        }
-        m_condition.notify_all();
-        for (auto& thread : m_threads)
-        {
-            if (thread.joinable())
-            {
-                thread.join();
-            }
-        }
+        m_running = false;
+        if (m_ownedPool)
+            return m_ownedPool->shutdown(timeout);
+        if (m_group.waitFor(timeout))
+            return 0;
+        return cancelPending();
     }
 
+    ThreadPool& getThreadPool() const
+    {
+        return m_pool;
+    }
+
+    // 以下统计针对底层线程池, 共享线程池时包含其它使用者的任务
     size_t getQueueSize() const
     {
-        std::unique_lock<std::mutex> lock(m_queueMutex);
-        return m_taskQueue.size();
+        return m_pool.getQueueSize();
     }
 
     size_t getActiveThreadCount() const
     {
-        return m_activeThreads.load();
+        return m_pool.getActiveThreads();
+    }
+
+    size_t getRejectedTaskCount() const
+    {
+        return m_pool.getRejectedTasks();
+    }
+
+    size_t getDroppedTaskCount() const
+    {
+        return m_pool.getDroppedTasks();
     }
 
 private:
-    void workerThread()
+    static ThreadPoolOptions toPoolOptions(const InvokeStrategyOptions& options)
     {
-        while (true)
-        {
-            std::packaged_task<void()> task;
-            {
-                std::unique_lock<std::mutex> lock(m_queueMutex);
-                m_condition.wait(lock, [this] { return !m_running || !m_taskQueue.empty(); });
-                if (!m_running && m_taskQueue.empty())
-                {
-                    return;
-                }
-                task = std::move(m_taskQueue.front());
-                m_taskQueue.pop();
-            }
-            m_activeThreads++;
-            task();
-            m_activeThreads--;
-        }
+        // listener 按提交顺序开始执行, 使用共享队列
+        ThreadPoolOptions poolOptions{SchedulingMode::SharedQueue};
+        poolOptions.affinity = options.affinity;
+        poolOptions.waitStrategy = options.waitStrategy;
+        poolOptions.capacity = options.capacity;
+        poolOptions.overflowPolicy = options.overflowPolicy;
+        return poolOptions;
+    }
+
+    size_t cancelPending()
+    {
+        const size_t before = m_group.getCancelledTasks();
+        m_group.cancel();
+        m_group.wait();
+        return m_group.getCancelledTasks() - before;
     }
 
-    std::vector<std::thread> m_threads;
-    std::queue<std::packaged_task<void()>> m_taskQueue;
-    mutable std::mutex m_queueMutex;
-    std::condition_variable m_condition;
-    std::atomic<bool> m_running;
-    std::atomic<size_t> m_activeThreads;
+    std::unique_ptr<ThreadPool> m_ownedPool;
+    ThreadPool& m_pool;
+    TaskGroup m_group;
+    std::atomic<bool> m_running{true};
 };
 
 }  // namespace comm
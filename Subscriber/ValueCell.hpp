@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+
+namespace comm
+{
+
+// Attribute 的值存储. store 在写锁内比较并赋值, 返回 false 表示值未变化且未要求强制写入.
+// 一般类型由读写锁保护, 读取时复制一份
+template<typename T>
+class ValueCell
+{
+public:
+    explicit ValueCell(const T& value)
+        : m_value(value)
+    {
+    }
+
+    T load() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_value;
+    }
+
+    bool store(const T& value, bool storeIfEqual)
+    {
+        std::unique_lock lock(m_mutex);
+        if (!storeIfEqual && m_value == value)
+            return false;
+        m_value = value;
+        return true;
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    T m_value;
+};
+
+// 可以无锁原子访问的类型 (int, double, 指针, 小的 POD 等): 读取是一次原子加载, 无等待, 读者之间不写共享的缓存行.
+// 写者之间用互斥锁串行, 保证比较与赋值不被其它写者打断
+template<typename T>
+    requires(std::is_trivially_copyable_v<T> && std::atomic<T>::is_always_lock_free)
+class ValueCell<T>
+{
+public:
+    explicit ValueCell(const T& value)
+        : m_value(value)
+    {
+    }
+
+    T load() const
+    {
+        return m_value.load(std::memory_order_acquire);
+    }
+
+    bool store(const T& value, bool storeIfEqual)
+    {
+        std::lock_guard lock(m_writeMutex);
+        if (!storeIfEqual && m_value.load(std::memory_order_relaxed) == value)
+            return false;
+        m_value.store(value, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<T> m_value;
+    std::mutex m_writeMutex;
+};
+
+// 其余可平凡复制的类型用 seqlock: 值按 8 字节分段存放在原子变量中, 写者在写入前后各递增一次序号,
+// 读者复制后检查序号未变且为偶数, 否则重试. 读者不写共享内存, 只在写入进行中重试
+template<typename T>
+    requires(std::is_trivially_copyable_v<T> && !std::atomic<T>::is_always_lock_free)
+class ValueCell<T>
+{
+public:
+    explicit ValueCell(const T& value)
+    {
+        write(value);
+    }
+
+    T load() const
+    {
+        while (true)
+        {
+            const uint64_t sequence = m_sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+                continue;
+            const T value = read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == sequence)
+                return value;
+        }
+    }
+
+    bool store(const T& value, bool storeIfEqual)
+    {
+        std::lock_guard lock(m_writeMutex);
+        if (!storeIfEqual && read() == value)
+            return false;
+        const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t Words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    T read() const
+    {
+        std::array<uint64_t, Words> words;
+        for (size_t i = 0; i < Words; ++i)
+        {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    void write(const T& value)
+    {
+        std::array<uint64_t, Words> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (size_t i = 0; i < Words; ++i)
+        {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint64_t> m_sequence{0};
+    std::array<std::atomic<uint64_t>, Words> m_words{};
+    std::mutex m_writeMutex;
+};
+
+}  // namespace comm
@@ -1,5 +1,8 @@
 #include "SubscriberTest.hpp"
 
+#include <set>
+#include <vector>
+
 namespace comm
 {
 namespace test
@@ -103,5 +106,432 @@ TEST_F(SubscribableTest, DifferentArgumentTypes)
     EXPECT_DOUBLE_EQ(doubleValue, 3.14);
 }
 
+Task<int> sumTwoNotifications(EventSync<int, int>& event)
+{
+    auto [a, b] = co_await nextNotification(event);
+    int first = a + b;
+    auto [c, d] = co_await nextNotification(event);
+    co_return first + c + d;
+}
+
+Task<int> awaitAttribute(Attribute<int>& attribute)
+{
+    co_return co_await nextNotification(attribute);
+}
+
+// 协程等待通知期间不占用线程, 每次等待只消费一次通知并自动撤销订阅
+TEST_F(SubscribableTest, AwaitNotificationInCoroutine)
+{
+    ThreadPool threadPool(1);
+
+    EventSync<int, int> event;
+    auto eventResult = spawn(threadPool, sumTwoNotifications(event));
+    while (!eventResult.isReady())
+    {
+        event.notify(1, 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(eventResult.get(), 6);
+
+    Attribute<int> attribute(testStrategy, 0);
+    auto attributeResult = spawn(threadPool, awaitAttribute(attribute));
+    for (int value = 1; !attributeResult.isReady(); ++value)
+    {
+        attribute.setValue(value);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(attributeResult.get(), 0);
+    EXPECT_EQ(attributeResult.get(), attribute.value());
+}
+
+// 同步执行与事件循环调用策略: listener 分别在通知线程和驱动循环的线程上执行
+TEST_F(SubscribableTest, InlineAndEventLoopStrategies)
+{
+    InlineInvokeStrategy inlineStrategy;
+    Event<int> inlineEvent(inlineStrategy);
+    int inlineSum = 0;
+    auto sum = inlineEvent.subscribe([&](int value) { inlineSum += value; });
+    auto thrower = inlineEvent.subscribe([](int) { throw std::runtime_error("Test exception"); });
+    auto after = inlineEvent.subscribe([&](int value) { inlineSum += value; });
+    inlineEvent.notify(5);
+    EXPECT_EQ(inlineSum, 10);
+
+    EventLoopInvokeStrategy loop;
+    Event<int> loopEvent(loop);
+    std::vector<int> received;
+    std::set<std::thread::id> threads;
+    auto collect = loopEvent.subscribe(
+        [&](int value)
+        {
+            received.push_back(value);
+            threads.insert(std::this_thread::get_id());
+        });
+    std::thread producer(
+        [&loopEvent]()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                loopEvent.notify(i);
+            }
+        });
+    producer.join();
+    EXPECT_TRUE(received.empty());
+    EXPECT_EQ(loop.getQueueSize(), 3u);
+    EXPECT_EQ(loop.runOnce(), 3u);
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(threads, (std::set<std::thread::id>{std::this_thread::get_id()}));
+    EXPECT_EQ(loop.runOnce(), 0u);
+
+    std::thread lateProducer(
+        [&loopEvent, &loop]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            loopEvent.notify(3);
+            loop.interrupt();
+        });
+    loop.runFor(std::chrono::seconds(5));
+    lateProducer.join();
+    loop.runOnce();
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(loop.runFor(std::chrono::milliseconds(1)), 0u);
+}
+
+// 自适应调用策略: 廉价 listener 测量后在通知线程上直接执行, 耗时的 listener 继续派发到线程池
+TEST_F(SubscribableTest, AdaptiveStrategyInlinesCheapListeners)
+{
+    ThreadPoolInvokeStrategy dispatcher(1);
+    AdaptiveInvokeStrategy adaptive(dispatcher, std::chrono::microseconds(200));
+    Event<int> event(adaptive);
+
+    std::atomic<int> cheapCalls{0};
+    std::atomic<int> slowCalls{0};
+    std::atomic<int> cheapOnCaller{0};
+    const auto caller = std::this_thread::get_id();
+    auto cheap = event.subscribe(
+        [&](int)
+        {
+            if (std::this_thread::get_id() == caller)
+                cheapOnCaller++;
+            cheapCalls++;
+        });
+    auto slow = event.subscribe(
+        [&](int)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            slowCalls++;
+        });
+
+    for (int i = 1; i <= 5; ++i)
+    {
+        event.notify(i);
+        while (cheapCalls < i || slowCalls < i)
+        {
+            std::this_thread::yield();
+        }
+    }
+    // 第一次通知时耗时未知, 两个 listener 都派发; 之后廉价 listener 改为同步执行
+    EXPECT_EQ(cheapOnCaller, 4);
+    EXPECT_EQ(adaptive.getInlinedCount(), 4u);
+    EXPECT_EQ(adaptive.getDispatchedCount(), 6u);
+}
+
+// 自适应调用策略的耗时按 listener 标识记录在各自的策略实例中: 新订阅的 listener 即使复用了已退订 listener 的内存
+// 也要重新测量, 另一个策略实例也不会使用本实例测得的耗时
+TEST_F(SubscribableTest, AdaptiveStrategyCostsArePerListenerAndInstance)
+{
+    ThreadPoolInvokeStrategy dispatcher(1);
+    AdaptiveInvokeStrategy first(dispatcher, std::chrono::milliseconds(100));
+    AdaptiveInvokeStrategy second(dispatcher, std::chrono::milliseconds(100));
+    TestSubscribable<int> subject;
+
+    std::atomic<int> calls{0};
+    auto notifyAndWait = [&](AdaptiveInvokeStrategy& strategy)
+    {
+        const int expected = calls + 1;
+        subject.testNotifyAsync(strategy, 0);
+        while (calls < expected)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    for (int round = 0; round < 8; ++round)
+    {
+        auto subscription = subject.subscribe([&](int) { calls++; });
+        notifyAndWait(first);
+        notifyAndWait(first);
+        EXPECT_EQ(first.getInlinedCount(), static_cast<size_t>(round + 1));
+        EXPECT_EQ(first.getDispatchedCount(), static_cast<size_t>(round + 1));
+    }
+
+    auto subscription = subject.subscribe([&](int) { calls++; });
+    notifyAndWait(first);
+    notifyAndWait(second);
+    EXPECT_EQ(second.getInlinedCount(), 0u);
+    EXPECT_EQ(second.getDispatchedCount(), 1u);
+}
+
+// 快照模式: 通知只读取订阅快照, 订阅与退订发布新快照; 并发增删订阅时通知不会访问已退订的 listener
+TEST_F(SubscribableTest, SnapshotModeNotifies)
+{
+    auto subject = std::make_shared<TestSubscribable<int>>(NotifyMode::Snapshot);
+    EXPECT_EQ(subject->getNotifyMode(), NotifyMode::Snapshot);
+    subject->testNotifySync(0);
+
+    std::atomic<int> sum{0};
+    auto first = subject->subscribe([&](int value) { sum += value; });
+    auto second = subject->subscribe([&](int value) { sum += value * 10; });
+    subject->testNotifySync(1);
+    EXPECT_EQ(sum, 11);
+    subject->testNotifyAsync(testStrategy, 2);
+    EXPECT_EQ(sum, 33);
+
+    second.reset();
+    subject->testNotifySync(1);
+    EXPECT_EQ(sum, 34);
+    first->unsubscribe();
+    subject->testNotifySync(1);
+    EXPECT_EQ(sum, 34);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> calls{0};
+    std::thread notifier(
+        [&]()
+        {
+            while (!done)
+            {
+                subject->testNotifySync(1);
+            }
+        });
+    for (int i = 0; i < 200; ++i)
+    {
+        auto churn = subject->subscribe([&](int) { calls++; });
+        std::this_thread::yield();
+    }
+    done = true;
+    notifier.join();
+    const int afterChurn = calls;
+    subject->testNotifySync(1);
+    EXPECT_EQ(calls, afterChurn);
+
+    Event<std::string> event(testStrategy, NotifyMode::Snapshot);
+    std::string received;
+    auto subscription = event.subscribe([&](const std::string& text) { received = text; });
+    event.notify("snapshot");
+    EXPECT_EQ(received, "snapshot");
+}
+
+// 槽位表: 删除 O(1) 且元素保持连续, 旧 Key 在槽位复用后失效
+TEST_F(SubscribableTest, SlotMapEraseKeepsValuesDense)
+{
+    SlotMap<int> slots;
+    std::vector<SlotMap<int>::Key> keys;
+    for (int i = 0; i < 10; ++i)
+    {
+        keys.push_back(slots.insert(i));
+    }
+    EXPECT_TRUE(slots.erase(keys[3]));
+    EXPECT_FALSE(slots.erase(keys[3]));
+    EXPECT_TRUE(slots.erase(keys[0]));
+    EXPECT_EQ(slots.size(), 8u);
+    EXPECT_EQ(slots.find(keys[3]), nullptr);
+    ASSERT_NE(slots.find(keys[9]), nullptr);
+    EXPECT_EQ(*slots.find(keys[9]), 9);
+
+    auto reused = slots.insert(42);
+    EXPECT_EQ(reused.index, keys[0].index);
+    EXPECT_FALSE(slots.contains(keys[0]));
+    EXPECT_EQ(*slots.find(reused), 42);
+
+    std::multiset<int> values(slots.values().begin(), slots.values().end());
+    EXPECT_EQ(values, (std::multiset<int>{1, 2, 4, 5, 6, 7, 8, 9, 42}));
+}
+
+// 订阅频繁增删: 退订立即从订阅表移除, 不依赖被订阅对象是否由 shared_ptr 管理
+TEST_F(SubscribableTest, UnsubscribeRemovesFromRegistry)
+{
+    for (auto mode : {NotifyMode::Locked, NotifyMode::Snapshot})
+    {
+        TestSubscribable<int> subject(mode);
+        std::atomic<int> calls{0};
+        std::vector<TestSubscribable<int>::SubscriptionPtr> subscriptions;
+        for (int i = 0; i < 100; ++i)
+        {
+            subscriptions.push_back(subject.subscribe([&](int) { calls++; }));
+        }
+        EXPECT_EQ(subject.getSubscriptionCount(), 100u);
+        for (size_t i = 0; i < subscriptions.size(); i += 2)
+        {
+            subscriptions[i].reset();
+        }
+        subscriptions[1]->unsubscribe();
+        EXPECT_EQ(subject.getSubscriptionCount(), 49u);
+        subject.testNotifySync(1);
+        EXPECT_EQ(calls, 49);
+
+        for (int round = 0; round < 1000; ++round)
+        {
+            auto churn = subject.subscribe([&](int) { calls++; });
+        }
+        EXPECT_EQ(subject.getSubscriptionCount(), 49u);
+    }
+
+    // 被订阅对象先于订阅销毁时退订是空操作
+    auto subject = std::make_unique<TestSubscribable<int>>();
+    auto orphan = subject->subscribe([](int) {});
+    subject.reset();
+    orphan->unsubscribe();
+}
+
+// 扇出派发: 每 FanOutChunkSize 个 listener 一个任务, 参数只复制一次, listener 的异常互不影响
+TEST_F(SubscribableTest, FanOutDispatchSharesPayload)
+{
+    static std::atomic<int> copies{0};
+    struct Payload
+    {
+        Payload() = default;
+        Payload(const Payload& other)
+            : values(other.values)
+        {
+            copies++;
+        }
+
+        std::vector<int> values = std::vector<int>(1000, 1);
+    };
+
+    EventLoopInvokeStrategy loop;
+    TestSubscribable<Payload> subject(NotifyMode::Snapshot, DispatchMode::FanOut);
+    std::atomic<int> sum{0};
+    std::vector<TestSubscribable<Payload>::SubscriptionPtr> subscriptions;
+    const size_t listenerCount = 2 * TestSubscribable<Payload>::FanOutChunkSize + 1;
+    for (size_t i = 0; i < listenerCount; ++i)
+    {
+        subscriptions.push_back(subject.subscribe(
+            [&sum, i](const Payload& payload)
+            {
+                if (i == 0)
+                    throw std::runtime_error("first listener fails");
+                sum += payload.values.front();
+            }));
+    }
+
+    Payload payload;
+    copies = 0;
+    subject.testNotifyAsync(loop, payload);
+    EXPECT_EQ(loop.getQueueSize(), 3u);
+    EXPECT_EQ(copies, 1);
+    EXPECT_EQ(loop.runOnce(), 3u);
+    EXPECT_EQ(sum, static_cast<int>(listenerCount) - 1);
+    EXPECT_EQ(copies, 1);
+
+    Event<std::vector<int>> event(testStrategy, NotifyMode::Locked, DispatchMode::FanOut);
+    EXPECT_EQ(event.getDispatchMode(), DispatchMode::FanOut);
+    size_t received = 0;
+    auto subscription = event.subscribe([&](const std::vector<int>& values) { received = values.size(); });
+    event.notify(std::vector<int>(42));
+    EXPECT_EQ(received, 42u);
+}
+
+// 合并投递: 每个订阅者最多一个待投递的通知, listener 只看到最新的值
+TEST_F(SubscribableTest, AttributeConflatesPendingValues)
+{
+    EventLoopInvokeStrategy loop;
+    Attribute<int> attribute(loop, 0, false, NotifyMode::Snapshot, DispatchMode::Conflate);
+    std::vector<int> first;
+    std::vector<int> second;
+    auto firstSubscription = attribute.subscribe([&](int value) { first.push_back(value); });
+    auto secondSubscription = attribute.subscribe([&](int value) { second.push_back(value); });
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        attribute.setValue(i);
+    }
+    EXPECT_EQ(loop.getQueueSize(), 2u);
+    loop.runOnce();
+    EXPECT_EQ(first, std::vector<int>{1000});
+    EXPECT_EQ(second, std::vector<int>{1000});
+
+    // 投递完成后新的值重新调度
+    attribute.setValue(7);
+    EXPECT_EQ(loop.getQueueSize(), 2u);
+    loop.runOnce();
+    EXPECT_EQ(first, (std::vector<int>{1000, 7}));
+
+    // 多线程持续更新: 最终投递的是最后一个值
+    ThreadPoolInvokeStrategy pool(2);
+    Attribute<int> shared(pool, 0, false, NotifyMode::Locked, DispatchMode::Conflate);
+    std::atomic<int> latest{0};
+    std::atomic<int> deliveries{0};
+    auto subscription = shared.subscribe(
+        [&](int value)
+        {
+            latest = value;
+            deliveries++;
+        });
+    for (int i = 1; i <= 10000; ++i)
+    {
+        shared.setValue(i);
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (latest != 10000 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+    pool.shutdown();
+    EXPECT_EQ(latest, 10000);
+    EXPECT_LE(deliveries, 10000);
+}
+
+// 可平凡复制的值读取不加锁: 不能原子访问的类型走 seqlock, 并发读写时不会读到写了一半的值
+TEST_F(SubscribableTest, AttributeLockFreeReads)
+{
+    struct Wide
+    {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        uint64_t c = 0;
+
+        bool operator==(const Wide&) const = default;
+    };
+
+    AttributeSync<Wide> attribute;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i)
+    {
+        readers.emplace_back(
+            [&]()
+            {
+                while (!done)
+                {
+                    const Wide value = attribute.value();
+                    if (value.a != value.b || value.b != value.c)
+                        torn++;
+                }
+            });
+    }
+    for (uint64_t i = 1; i <= 20000; ++i)
+    {
+        attribute.setValue(Wide{i, i, i});
+    }
+    done = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(attribute.value().c, 20000u);
+    EXPECT_FALSE(attribute.setValue(Wide{20000, 20000, 20000}));
+
+    Attribute<double> number(testStrategy, 1.5);
+    double received = 0;
+    auto subscription = number.subscribe([&](double value) { received = value; });
+    EXPECT_TRUE(number.setValue(2.5));
+    EXPECT_FALSE(number.setValue(2.5));
+    EXPECT_EQ(number.value(), 2.5);
+    EXPECT_EQ(received, 2.5);
+}
+
 }  // namespace test
 }  // namespace comm
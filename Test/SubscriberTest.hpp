@@ -3,8 +3,18 @@
 #include <gtest/gtest.h>
 #include <atomic>
 #include <chrono>
+#include <set>
 #include <thread>
+#include "AdaptiveInvokeStrategy.hpp"
+#include "Attribute.hpp"
+#include "Awaitable.hpp"
+#include "Coroutine.hpp"
+#include "Event.hpp"
+#include "EventLoopInvokeStrategy.hpp"
+#include "InlineInvokeStrategy.hpp"
+#include "SlotMap.hpp"
 #include "Subscriber.hpp"
+#include "ThreadPoolInvokeStrategy.hpp"
 
 namespace comm
 {
@@ -0,0 +1,1570 @@
+#include "ThreadPoolTest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+
+namespace threadpool
+{
+namespace test
+{
+
+void ThreadPoolTest::SetUp()
+{
+    // 在每个测试用例开始前执行的设置
+}
+
+void ThreadPoolTest::TearDown()
+{
+    // 在每个测试用例结束后执行的清理
+}
+
+// 工作窃取模式下所有任务都能执行完成
+TEST_F(ThreadPoolTest, WorkStealingRunsAllTasks)
+{
+    ThreadPool threadPool(ThreadCount, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 1000; ++i)
+    {
+        results.emplace_back(threadPool.enqueue([](int n) { return n * 2; }, i));
+    }
+
+    long long sum = 0;
+    for (auto& result : results)
+    {
+        sum += result.get();
+    }
+    EXPECT_EQ(sum, 999LL * 1000);
+    EXPECT_EQ(threadPool.getTotalTasks(), 1000u);
+}
+
+// 工作线程内提交的子任务进入本地队列, 也能被正常执行
+TEST_F(ThreadPoolTest, WorkStealingNestedSubmission)
+{
+    ThreadPool threadPool(ThreadCount, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    std::atomic<int> counter{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 8; ++i)
+    {
+        outer.emplace_back(threadPool.enqueue(
+            [&]()
+            {
+                for (int j = 0; j < 100; ++j)
+                {
+                    threadPool.enqueue([&]() { counter++; });
+                }
+            }));
+    }
+    for (auto& f : outer)
+    {
+        f.get();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter < 800 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(counter, 800);
+}
+
+// 析构时会执行完队列中剩余的任务
+TEST_F(ThreadPoolTest, DestructorDrainsQueue)
+{
+    std::atomic<int> counter{0};
+    {
+        ThreadPool threadPool(ThreadCount, ThreadPoolOptions{SchedulingMode::WorkStealing});
+        for (int i = 0; i < 500; ++i)
+        {
+            threadPool.enqueue([&]() { counter++; });
+        }
+    }
+    EXPECT_EQ(counter, 500);
+}
+
+// 批量提交的结果与逐个提交一致, 两种调度模式都覆盖
+TEST_F(ThreadPoolTest, EnqueueBulkReturnsAllFutures)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool threadPool(ThreadCount, ThreadPoolOptions{mode});
+        std::vector<int> inputs(1000);
+        std::iota(inputs.begin(), inputs.end(), 0);
+
+        auto results = threadPool.enqueueBulk(inputs, [](int n) { return n * n; });
+        ASSERT_EQ(results.size(), inputs.size());
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            EXPECT_EQ(results[i].get(), static_cast<int>(i * i));
+        }
+        EXPECT_EQ(threadPool.getTotalTasks(), inputs.size());
+    }
+}
+
+// post 提交的任务不返回 future, 大闭包退回堆存储也能正确执行
+TEST_F(ThreadPoolTest, PostRunsSmallAndLargeCallables)
+{
+    ThreadPool threadPool(ThreadCount);
+    std::atomic<int> counter{0};
+    std::array<char, 256> payload{};
+    payload[0] = 1;
+
+    static_assert(UniqueTask::fitsInline<std::packaged_task<int()>>());
+    for (int i = 0; i < 100; ++i)
+    {
+        threadPool.post([&counter]() { counter++; });
+        threadPool.post([&counter, payload]() { counter += payload[0]; });
+        threadPool.post([&counter](int n) { counter += n; }, 1);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter < 300 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(counter, 300);
+}
+
+// 直方图分桶与分位数估算, 以及线程池统计合并
+TEST_F(ThreadPoolTest, LatencyHistogramPercentiles)
+{
+    for (uint64_t value : {0ULL, 15ULL, 16ULL, 1000ULL, 123456789ULL})
+    {
+        const uint64_t estimate = LatencyHistogram::bucketValue(LatencyHistogram::bucketIndex(value));
+        EXPECT_NEAR(static_cast<double>(estimate), static_cast<double>(value), value / 16.0 + 1);
+    }
+
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        histogram.record(i * 1000);
+    }
+    HistogramSnapshot snapshot;
+    snapshot.merge(histogram);
+    LatencySummary summary = snapshot.summary();
+    EXPECT_EQ(summary.count, 1000u);
+    EXPECT_EQ(summary.min, 1000u);
+    EXPECT_EQ(summary.max, 1000000u);
+    EXPECT_NEAR(static_cast<double>(summary.p50), 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(static_cast<double>(summary.p99), 990000.0, 990000.0 / 16);
+
+    ThreadPool threadPool(ThreadCount);
+    for (int i = 0; i < 100; ++i)
+    {
+        threadPool.enqueue([]() {}).get();
+    }
+    // 统计在任务完成之后才记录, 等待最后一个分片写入
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (threadPool.getLatencyStats().execution.count < 100 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(threadPool.getLatencyStats().execution.count, 100u);
+    threadPool.resetStats();
+    EXPECT_EQ(threadPool.getLatencyStats().queueWait.count, 0u);
+}
+
+// 单线程下验证执行顺序: 紧急通道按截止时间排序, 然后是普通任务, 最后是低优先级任务
+TEST_F(ThreadPoolTest, PriorityLanesOrdering)
+{
+    ThreadPool threadPool(1, ThreadPoolOptions{SchedulingMode::SharedQueue, std::chrono::seconds(10)});
+    std::promise<void> gate;
+    auto blocker = threadPool.enqueue([future = gate.get_future().share()]() { future.wait(); });
+
+    std::mutex orderMutex;
+    std::vector<std::string> order;
+    auto record = [&](std::string name)
+    {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order.push_back(std::move(name));
+    };
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> results;
+    results.push_back(threadPool.enqueue(TaskPriority::Low, record, "low"));
+    results.push_back(threadPool.enqueue(record, "normal"));
+    results.push_back(threadPool.enqueue(now + std::chrono::seconds(2), record, "deadline-late"));
+    results.push_back(threadPool.enqueue(now + std::chrono::seconds(1), record, "deadline-early"));
+    results.push_back(threadPool.enqueue(TaskPriority::High, record, "high"));
+    gate.set_value();
+    for (auto& result : results)
+    {
+        result.get();
+    }
+
+    std::vector<std::string> expected{"high", "deadline-early", "deadline-late", "normal", "low"};
+    EXPECT_EQ(order, expected);
+}
+
+// 低优先级任务等待超过老化阈值后会排在普通任务之前
+TEST_F(ThreadPoolTest, LowPriorityAging)
+{
+    ThreadPool threadPool(1, ThreadPoolOptions{SchedulingMode::WorkStealing, std::chrono::milliseconds(1)});
+    std::promise<void> gate;
+    auto blocker = threadPool.enqueue([future = gate.get_future().share()]() { future.wait(); });
+
+    std::vector<std::string> order;
+    auto low = threadPool.enqueue(TaskPriority::Low, [&]() { order.push_back("low"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto normal = threadPool.enqueue([&]() { order.push_back("normal"); });
+    gate.set_value();
+    low.get();
+    normal.get();
+
+    std::vector<std::string> expected{"low", "normal"};
+    EXPECT_EQ(order, expected);
+}
+
+// 弹性模式: 队列积压时扩容到上限, 空闲超时后回落到下限
+TEST_F(ThreadPoolTest, ElasticGrowAndShrink)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPoolOptions options;
+        options.mode = mode;
+        options.minThreads = 1;
+        options.maxThreads = 4;
+        options.idleTimeout = std::chrono::milliseconds(20);
+        options.scalingPolicy = std::make_shared<ThresholdScalingPolicy>(0);
+        ThreadPool threadPool(1, options);
+        EXPECT_TRUE(threadPool.isElastic());
+        EXPECT_EQ(threadPool.getThreadCount(), 1u);
+
+        std::promise<void> gate;
+        std::shared_future<void> released = gate.get_future().share();
+        std::vector<std::future<void>> blockers;
+        for (int i = 0; i < 8; ++i)
+        {
+            blockers.push_back(threadPool.enqueue([released]() { released.wait(); }));
+        }
+        EXPECT_EQ(threadPool.getThreadCount(), 4u);
+
+        gate.set_value();
+        for (auto& blocker : blockers)
+        {
+            blocker.get();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (threadPool.getThreadCount() > 1 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(threadPool.getThreadCount(), 1u);
+
+        // 缩容后依然可以正常提交任务
+        EXPECT_EQ(threadPool.enqueue([]() { return 7; }).get(), 7);
+    }
+}
+
+// 并行算法在两种分块方式下的结果与串行算法一致
+TEST_F(ThreadPoolTest, ParallelAlgorithmsMatchSerial)
+{
+    ThreadPool threadPool(ThreadCount, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    std::vector<long long> input(100003);
+    std::iota(input.begin(), input.end(), 1);
+
+    for (auto partitioner : {Partitioner::Static, Partitioner::Adaptive})
+    {
+        ParallelOptions options{partitioner, 0};
+
+        std::vector<int> visited(input.size(), 0);
+        parallelFor(threadPool, size_t{0}, visited.size(), [&](size_t i) { visited[i]++; }, options);
+        EXPECT_EQ(std::count(visited.begin(), visited.end(), 1), static_cast<long>(visited.size()));
+
+        EXPECT_EQ(parallelReduce(threadPool, input.begin(), input.end(), 0LL, std::plus<>{}, options),
+                  std::accumulate(input.begin(), input.end(), 0LL));
+
+        std::vector<long long> doubled(input.size());
+        parallelTransform(threadPool, input.begin(), input.end(), doubled.begin(), [](long long n) { return n * 2; },
+                          options);
+        EXPECT_EQ(doubled.back(), input.back() * 2);
+
+        std::vector<long long> scanned(input.size());
+        std::vector<long long> expected(input.size());
+        parallelScan(threadPool, input.begin(), input.end(), scanned.begin(), std::plus<>{}, options);
+        std::inclusive_scan(input.begin(), input.end(), expected.begin());
+        EXPECT_EQ(scanned, expected);
+    }
+}
+
+// 在工作线程内嵌套调用 parallelFor 不会死锁, 异常会传回调用线程
+TEST_F(ThreadPoolTest, ParallelForNestedAndExceptions)
+{
+    ThreadPool threadPool(2);
+    std::atomic<int> counter{0};
+    parallelFor(threadPool, 0, 8,
+                [&](int)
+                {
+                    parallelFor(threadPool, 0, 100, [&](int) { counter++; });
+                });
+    EXPECT_EQ(counter, 800);
+
+    EXPECT_THROW(parallelFor(threadPool, 0, 1000,
+                             [](int i)
+                             {
+                                 if (i == 500)
+                                     throw std::runtime_error("failed");
+                             }),
+                 std::runtime_error);
+}
+
+// 后续任务串联多个阶段, 异常沿链传递, whenAll/whenAny 汇总多个结果
+TEST_F(ThreadPoolTest, TaskFutureContinuations)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool threadPool(ThreadCount, ThreadPoolOptions{mode});
+
+        auto chained = spawn(threadPool, [](int n) { return n + 1; }, 1)
+                           .then([](const int& n) { return n * 10; })
+                           .then([](const int& n) { return std::to_string(n); });
+        EXPECT_EQ(chained.get(), "20");
+
+        bool skipped = true;
+        auto failed = spawn(threadPool, []() -> int { throw std::runtime_error("stage 1"); })
+                          .then([&skipped](const int&) { skipped = false; });
+        EXPECT_THROW(failed.get(), std::runtime_error);
+        EXPECT_TRUE(skipped);
+
+        std::vector<TaskFuture<int>> parts;
+        for (int i = 0; i < 16; ++i)
+        {
+            parts.push_back(spawn(threadPool, [i]() { return i * i; }));
+        }
+        auto total = whenAll(parts).then([](const std::vector<int>& values)
+                                         { return std::accumulate(values.begin(), values.end(), 0); });
+        EXPECT_EQ(total.get(), 1240);
+
+        auto slow = spawn(threadPool, []() { std::this_thread::sleep_for(std::chrono::milliseconds(200)); });
+        auto fast = spawn(threadPool, []() { return 1; });
+        EXPECT_EQ(whenAny(slow, fast).get(), 1u);
+        whenAll(slow, fast).get();
+        EXPECT_TRUE(slow.isReady());
+    }
+}
+
+// 菱形依赖按拓扑顺序执行, 可重复运行; 环和异常都会报告给调用方
+TEST_F(ThreadPoolTest, TaskGraphDependencies)
+{
+    ThreadPool threadPool(ThreadCount, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    std::atomic<int> step{0};
+    int a = -1, b = -1, c = -1, d = -1;
+
+    TaskGraph graph;
+    auto first = graph.add([&]() { a = step++; });
+    auto left = graph.add([&]() { b = step++; });
+    auto right = graph.add([&]() { c = step++; });
+    auto last = graph.add([&]() { d = step++; });
+    graph.precede(first, left);
+    graph.precede(first, right);
+    graph.precede(left, last);
+    graph.precede(right, last);
+
+    for (int run = 0; run < 3; ++run)
+    {
+        step = 0;
+        graph.run(threadPool).get();
+        EXPECT_EQ(a, 0);
+        EXPECT_LT(a, b);
+        EXPECT_LT(a, c);
+        EXPECT_EQ(d, 3);
+    }
+
+    TaskGraph wide;
+    std::atomic<int> counter{0};
+    auto sink = wide.add([&]() { EXPECT_EQ(counter.load(), 1000); });
+    for (int i = 0; i < 1000; ++i)
+    {
+        wide.precede(wide.add([&]() { counter++; }), sink);
+    }
+    wide.run(threadPool).get();
+
+    TaskGraph cyclic;
+    auto x = cyclic.add([]() {});
+    auto y = cyclic.add([]() {});
+    cyclic.precede(x, y);
+    cyclic.precede(y, x);
+    EXPECT_THROW(cyclic.run(threadPool), std::logic_error);
+
+    TaskGraph failing;
+    bool reached = false;
+    failing.precede(failing.add([]() { throw std::runtime_error("node"); }),
+                    failing.add([&reached]() { reached = true; }));
+    EXPECT_THROW(failing.run(threadPool).get(), std::runtime_error);
+    EXPECT_FALSE(reached);
+}
+
+Task<int> addOnPool(ThreadPool& threadPool, int a, int b)
+{
+    co_await threadPool.schedule();
+    co_return a + b;
+}
+
+Task<int> waitThenAdd(ThreadPool& threadPool, TaskFuture<void> gate, int value)
+{
+    co_await gate;
+    int sum = co_await addOnPool(threadPool, value, 1);
+    co_return sum;
+}
+
+Task<void> throwOnPool(ThreadPool& threadPool)
+{
+    co_await threadPool.schedule();
+    throw std::runtime_error("coroutine");
+}
+
+// 大量协程挂起等待同一个结果时不占用工作线程, 恢复后在线程池上继续执行
+TEST_F(ThreadPoolTest, CoroutinesSuspendWithoutHoldingThreads)
+{
+    ThreadPool threadPool(2, ThreadPoolOptions{SchedulingMode::WorkStealing});
+    EXPECT_EQ(spawn(threadPool, addOnPool(threadPool, 20, 22)).get(), 42);
+
+    auto gate = spawn(threadPool, []() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+    std::vector<TaskFuture<int>> flows;
+    for (int i = 0; i < 2000; ++i)
+    {
+        flows.push_back(spawn(threadPool, waitThenAdd(threadPool, gate, i)));
+    }
+    auto results = whenAll(flows);
+    long long total = 0;
+    for (int value : results.get())
+    {
+        total += value;
+    }
+    EXPECT_EQ(total, 2000LL * 1999 / 2 + 2000);
+
+    EXPECT_THROW(spawn(threadPool, throwOnPool(threadPool)).get(), std::runtime_error);
+}
+
+// 各种绑定策略下任务都能正常执行, 绑定后工作线程只运行在分配给它的 CPU 上
+TEST_F(ThreadPoolTest, AffinityPlacement)
+{
+    const auto& topology = CpuTopology::instance();
+    ASSERT_FALSE(topology.cpus().empty());
+
+    for (auto affinityMode : {AffinityMode::Compact, AffinityMode::Scatter, AffinityMode::NumaPartitioned})
+    {
+        AffinityPlan plan(AffinityOptions{affinityMode, {}}, ThreadCount);
+        ASSERT_TRUE(plan.enabled());
+        for (size_t worker = 0; worker < ThreadCount; ++worker)
+        {
+            EXPECT_FALSE(plan.cpusOf(worker).empty());
+        }
+
+        ThreadPoolOptions options{SchedulingMode::WorkStealing};
+        options.affinity.mode = affinityMode;
+        ThreadPool threadPool(ThreadCount, options);
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 100; ++i)
+        {
+            results.push_back(threadPool.enqueue([i]() { return i; }));
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            EXPECT_EQ(results[i].get(), i);
+        }
+    }
+
+#if defined(__linux__)
+    // 只允许第一个可用 CPU 时所有任务都在该 CPU 上执行
+    const int firstCpu = topology.cpus().front().cpu;
+    ThreadPoolOptions options;
+    options.affinity = AffinityOptions{AffinityMode::Compact, {firstCpu}};
+    ThreadPool pinnedPool(2, options);
+    for (int i = 0; i < 20; ++i)
+    {
+        EXPECT_EQ(pinnedPool.enqueue([]() { return sched_getcpu(); }).get(), firstCpu);
+    }
+#endif
+}
+
+// 三种等待策略下两种调度模式都能执行完所有任务, 忙轮询的弹性线程池空闲超时后依然会缩容
+TEST_F(ThreadPoolTest, WaitStrategies)
+{
+    for (auto waitMode : {WaitMode::Block, WaitMode::SpinThenPark, WaitMode::BusyPoll})
+    {
+        for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+        {
+            ThreadPoolOptions options{mode};
+            options.waitStrategy.mode = waitMode;
+            ThreadPool threadPool(2, options);
+            std::atomic<int> counter{0};
+            for (int round = 0; round < 50; ++round)
+            {
+                threadPool.enqueue([&counter]() { counter++; }).get();
+            }
+            for (int i = 0; i < 1000; ++i)
+            {
+                threadPool.post([&counter]() { counter++; });
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (counter < 1050 && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            EXPECT_EQ(counter, 1050);
+        }
+
+        std::atomic<int> invoked{0};
+        {
+            comm::InvokeStrategyOptions strategyOptions;
+            strategyOptions.waitStrategy.mode = waitMode;
+            comm::ThreadPoolInvokeStrategy strategy(2, strategyOptions);
+            for (int i = 0; i < 100; ++i)
+            {
+                strategy.invoke([&invoked]() { invoked++; });
+            }
+        }
+        EXPECT_EQ(invoked, 100);
+    }
+
+    ThreadPoolOptions options;
+    options.minThreads = 1;
+    options.maxThreads = 2;
+    options.idleTimeout = std::chrono::milliseconds(20);
+    options.waitStrategy.mode = WaitMode::BusyPoll;
+    ThreadPool elasticPool(2, options);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (elasticPool.getThreadCount() > 1 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(elasticPool.getThreadCount(), 1u);
+    EXPECT_EQ(elasticPool.enqueue([]() { return 3; }).get(), 3);
+}
+
+// 有界队列在满时按溢出策略拒绝, 丢弃, 就地执行或阻塞提交方
+TEST_F(ThreadPoolTest, BoundedQueueOverflowPolicies)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        for (auto policy : {OverflowPolicy::Reject, OverflowPolicy::DropOldest, OverflowPolicy::CallerRuns,
+                            OverflowPolicy::Block})
+        {
+            ThreadPoolOptions options{mode};
+            options.capacity = 4;
+            options.overflowPolicy = policy;
+            ThreadPool threadPool(1, options);
+            EXPECT_EQ(threadPool.getCapacity(), 4u);
+
+            // 占住唯一的工作线程, 让后续任务留在队列中
+            std::promise<void> release;
+            std::shared_future<void> gate = release.get_future().share();
+            std::atomic<bool> started{false};
+            threadPool.post(
+                [gate, &started]()
+                {
+                    started = true;
+                    gate.wait();
+                });
+            while (!started)
+            {
+                std::this_thread::yield();
+            }
+
+            std::vector<std::future<int>> queued;
+            for (int i = 0; i < 4; ++i)
+            {
+                queued.push_back(threadPool.enqueue([i]() { return i; }));
+            }
+
+            if (policy == OverflowPolicy::Reject)
+            {
+                EXPECT_THROW(threadPool.enqueue([]() { return 4; }), QueueFullError);
+                EXPECT_EQ(threadPool.getRejectedTasks(), 1u);
+                release.set_value();
+                for (int i = 0; i < 4; ++i)
+                {
+                    EXPECT_EQ(queued[i].get(), i);
+                }
+            }
+            else if (policy == OverflowPolicy::DropOldest)
+            {
+                auto newest = threadPool.enqueue([]() { return 4; });
+                EXPECT_EQ(threadPool.getDroppedTasks(), 1u);
+                release.set_value();
+                EXPECT_EQ(newest.get(), 4);
+                size_t broken = 0;
+                for (auto& result : queued)
+                {
+                    try
+                    {
+                        result.get();
+                    }
+                    catch (const std::future_error& error)
+                    {
+                        EXPECT_EQ(error.code(), std::future_errc::broken_promise);
+                        broken++;
+                    }
+                }
+                EXPECT_EQ(broken, 1u);
+            }
+            else if (policy == OverflowPolicy::CallerRuns)
+            {
+                const auto caller = std::this_thread::get_id();
+                auto inlined = threadPool.enqueue([]() { return std::this_thread::get_id(); });
+                EXPECT_EQ(inlined.get(), caller);
+                release.set_value();
+                for (int i = 0; i < 4; ++i)
+                {
+                    EXPECT_EQ(queued[i].get(), i);
+                }
+            }
+            else
+            {
+                std::thread releaser(
+                    [&release]()
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                        release.set_value();
+                    });
+                EXPECT_EQ(threadPool.enqueue([]() { return 4; }).get(), 4);
+                releaser.join();
+                // 工作线程内的阻塞提交退化为就地执行, 队列满时不会等待自己腾出空位
+                std::atomic<int> innerSum{0};
+                threadPool
+                    .enqueue(
+                        [&threadPool, &innerSum]()
+                        {
+                            for (int i = 0; i < 8; ++i)
+                            {
+                                threadPool.post([i, &innerSum]() { innerSum += i; });
+                            }
+                        })
+                    .get();
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (innerSum < 28 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                EXPECT_EQ(innerSum, 28);
+            }
+        }
+    }
+
+    comm::InvokeStrategyOptions strategyOptions;
+    strategyOptions.capacity = 2;
+    strategyOptions.overflowPolicy = OverflowPolicy::Reject;
+    comm::ThreadPoolInvokeStrategy strategy(1, strategyOptions);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::atomic<bool> started{false};
+    std::atomic<int> invoked{0};
+    strategy.invoke(
+        [gate, &started]()
+        {
+            started = true;
+            gate.wait();
+        });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    strategy.invoke([&invoked]() { invoked++; });
+    strategy.invoke([&invoked]() { invoked++; });
+    EXPECT_THROW(strategy.invoke([&invoked]() { invoked++; }), QueueFullError);
+    EXPECT_EQ(strategy.getRejectedTaskCount(), 1u);
+    release.set_value();
+    strategy.shutdown();
+    EXPECT_EQ(invoked, 2);
+}
+
+// 任务组取消后未开始的任务被跳过, 正在执行的任务通过停止令牌提前结束
+TEST_F(ThreadPoolTest, TaskGroupCancellation)
+{
+    ThreadPool threadPool(1);
+    std::atomic<int> executed{0};
+    std::atomic<bool> started{false};
+    std::optional<std::future<int>> first;
+    std::vector<std::future<int>> skipped;
+    {
+        TaskGroup group(threadPool);
+        first = group.enqueue(
+            [&started](std::stop_token token)
+            {
+                started = true;
+                while (!token.stop_requested())
+                {
+                    std::this_thread::yield();
+                }
+                return -1;
+            });
+        for (int i = 0; i < 10; ++i)
+        {
+            skipped.push_back(group.enqueue([&executed, i]() { return executed++, i; }));
+        }
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+        group.cancel();
+        group.wait();
+        EXPECT_TRUE(group.isCancelled());
+        EXPECT_EQ(group.getCancelledTasks(), 10u);
+    }
+    EXPECT_EQ(first->get(), -1);
+    EXPECT_EQ(executed, 0);
+    for (auto& result : skipped)
+    {
+        EXPECT_THROW(result.get(), std::future_error);
+    }
+
+    // 未取消的任务组正常执行所有任务
+    TaskGroup group(threadPool);
+    for (int i = 0; i < 100; ++i)
+    {
+        group.post([&executed]() { executed++; });
+    }
+    group.wait();
+    EXPECT_EQ(executed, 100);
+    EXPECT_EQ(group.getCancelledTasks(), 0u);
+}
+
+// shutdownNow 丢弃排队任务并返回数量, 有时限的关闭在超时前能排空时不丢弃任务
+TEST_F(ThreadPoolTest, ShutdownNowAndTimedDrain)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool threadPool(1, ThreadPoolOptions{mode});
+        std::atomic<bool> started{false};
+        std::atomic<bool> stopRequested{false};
+        auto blocker = threadPool.enqueue(
+            [&threadPool, &started, &stopRequested]()
+            {
+                started = true;
+                auto token = threadPool.getStopToken();
+                while (!token.stop_requested())
+                {
+                    std::this_thread::yield();
+                }
+                stopRequested = true;
+            });
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+        std::vector<std::future<void>> queued;
+        for (int i = 0; i < 50; ++i)
+        {
+            queued.push_back(threadPool.enqueue(i % 2 == 0 ? TaskPriority::High : TaskPriority::Low, []() {}));
+        }
+        TaskGroup group(threadPool);
+        group.post([]() {});
+
+        EXPECT_EQ(threadPool.shutdownNow(), 51u);
+        EXPECT_TRUE(stopRequested);
+        EXPECT_TRUE(group.isCancelled());
+        EXPECT_EQ(threadPool.getQueueSize(), 0u);
+        blocker.get();
+        for (auto& result : queued)
+        {
+            EXPECT_THROW(result.get(), std::future_error);
+        }
+        EXPECT_THROW(threadPool.post([]() {}), std::runtime_error);
+        EXPECT_EQ(threadPool.shutdownNow(), 0u);
+    }
+
+    ThreadPool drained(2);
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 100; ++i)
+    {
+        drained.post([&counter]() { counter++; });
+    }
+    EXPECT_EQ(drained.shutdown(std::chrono::seconds(5)), 0u);
+    EXPECT_EQ(counter, 100);
+
+    ThreadPool timedOut(1);
+    std::atomic<bool> release{false};
+    timedOut.post(
+        [&release]()
+        {
+            while (!release)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    for (int i = 0; i < 10; ++i)
+    {
+        timedOut.post([&counter]() { counter++; });
+    }
+    std::thread releaser(
+        [&release, &timedOut]()
+        {
+            // 超时后停止令牌被触发, 再放行正在执行的任务
+            while (!timedOut.getStopToken().stop_requested())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            release = true;
+        });
+    EXPECT_EQ(timedOut.shutdown(std::chrono::milliseconds(20)), 10u);
+    releaser.join();
+    EXPECT_EQ(counter, 100);
+
+    comm::ThreadPoolInvokeStrategy strategy(1);
+    std::atomic<bool> invokeStarted{false};
+    std::atomic<bool> invokeRelease{false};
+    strategy.invoke(
+        [&invokeStarted, &invokeRelease]()
+        {
+            invokeStarted = true;
+            while (!invokeRelease)
+            {
+                std::this_thread::yield();
+            }
+        });
+    while (!invokeStarted)
+    {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < 20; ++i)
+    {
+        strategy.invoke([&counter]() { counter++; });
+    }
+    std::thread invokeReleaser(
+        [&strategy, &invokeRelease]()
+        {
+            while (strategy.getQueueSize() > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            invokeRelease = true;
+        });
+    EXPECT_EQ(strategy.shutdownNow(), 20u);
+    invokeReleaser.join();
+    EXPECT_EQ(counter, 100);
+}
+
+// 调用策略作为已有线程池的适配器: listener 在该线程池的工作线程上执行, 关闭策略不影响线程池
+TEST_F(ThreadPoolTest, InvokeStrategySharesThreadPool)
+{
+    ThreadPool threadPool(2);
+    std::atomic<size_t> invokedCount{0};
+    std::mutex idsMutex;
+    std::set<std::thread::id> workerIds;
+    {
+        comm::ThreadPoolInvokeStrategy strategy(threadPool);
+        EXPECT_EQ(&strategy.getThreadPool(), &threadPool);
+        for (int i = 0; i < 100; ++i)
+        {
+            strategy.invoke(
+                [&]()
+                {
+                    std::lock_guard<std::mutex> lock(idsMutex);
+                    workerIds.insert(std::this_thread::get_id());
+                    invokedCount++;
+                });
+        }
+        strategy.shutdown();
+        EXPECT_EQ(invokedCount, 100u);
+        EXPECT_THROW(strategy.invoke([]() {}), std::runtime_error);
+    }
+    EXPECT_LE(workerIds.size(), 2u);
+    EXPECT_EQ(workerIds.count(std::this_thread::get_id()), 0u);
+    EXPECT_EQ(threadPool.enqueue([]() { return 1; }).get(), 1);
+
+    // 共享线程池时 shutdownNow 只取消本策略提交的任务
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::atomic<int> started{0};
+    for (int i = 0; i < 2; ++i)
+    {
+        threadPool.post(
+            [gate, &started]()
+            {
+                started++;
+                gate.wait();
+            });
+    }
+    while (started < 2)
+    {
+        std::this_thread::yield();
+    }
+    comm::ThreadPoolInvokeStrategy strategy(threadPool);
+    std::atomic<int> invoked{0};
+    for (int i = 0; i < 10; ++i)
+    {
+        strategy.invoke([&invoked]() { invoked++; });
+    }
+    auto other = threadPool.enqueue([]() { return 2; });
+    std::thread releaser(
+        [&release]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            release.set_value();
+        });
+    EXPECT_EQ(strategy.shutdownNow(), 10u);
+    releaser.join();
+    EXPECT_EQ(invoked, 0);
+    EXPECT_EQ(other.get(), 2);
+}
+
+// 计时方式与采样: TSC 计时与 steady_clock 结果一致, 采样只统计部分任务, 关闭后不产生统计
+TEST_F(ThreadPoolTest, TaskTimingModes)
+{
+    auto waitForCount = [](const ThreadPool& threadPool, uint64_t expected)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (threadPool.getLatencyStats().execution.count < expected && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    for (auto timingMode : {TimingMode::SteadyClock, TimingMode::Tsc})
+    {
+        ThreadPoolOptions options;
+        options.timing.mode = timingMode;
+        ThreadPool threadPool(1, options);
+        for (int i = 0; i < 5; ++i)
+        {
+            threadPool.enqueue([]() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }).get();
+        }
+        waitForCount(threadPool, 5);
+        const LatencySummary execution = threadPool.getLatencyStats().execution;
+        EXPECT_EQ(execution.count, 5u);
+        EXPECT_GE(execution.mean, 1.5e6);
+        EXPECT_LT(execution.mean, 50e6);
+    }
+
+    ThreadPoolOptions sampled;
+    sampled.timing.sampleInterval = 4;
+    ThreadPool sampledPool(1, sampled);
+    for (int i = 0; i < 100; ++i)
+    {
+        sampledPool.enqueue([]() {}).get();
+    }
+    waitForCount(sampledPool, 25);
+    EXPECT_EQ(sampledPool.getLatencyStats().execution.count, 25u);
+    EXPECT_EQ(sampledPool.getTotalTasks(), 100u);
+
+    // 采样计数属于各自的线程池, 同一线程交替向两个线程池提交时互不干扰
+    ThreadPoolOptions everySecond;
+    everySecond.timing.sampleInterval = 2;
+    ThreadPoolOptions everyThird;
+    everyThird.timing.sampleInterval = 3;
+    ThreadPool halfPool(1, everySecond);
+    ThreadPool thirdPool(1, everyThird);
+    for (int i = 0; i < 60; ++i)
+    {
+        halfPool.enqueue([]() {}).get();
+        thirdPool.enqueue([]() {}).get();
+    }
+    waitForCount(halfPool, 30);
+    waitForCount(thirdPool, 20);
+    EXPECT_EQ(halfPool.getLatencyStats().execution.count, 30u);
+    EXPECT_EQ(thirdPool.getLatencyStats().execution.count, 20u);
+
+    ThreadPoolOptions off;
+    off.timing.mode = TimingMode::Off;
+    ThreadPool offPool(2, off);
+    std::vector<int> values(100);
+    std::iota(values.begin(), values.end(), 0);
+    auto results = offPool.enqueueBulk(values, [](int value) { return value; });
+    int sum = 0;
+    for (auto& result : results)
+    {
+        sum += result.get();
+    }
+    EXPECT_EQ(sum, 4950);
+    EXPECT_EQ(offPool.getLatencyStats().execution.count, 0u);
+    EXPECT_EQ(offPool.getLatencyStats().queueWait.count, 0u);
+}
+
+// 按 key 串行: 同一 key 的任务按提交顺序执行且不并发, 不同 key 并行; Strand 对象提供同样的保证
+TEST_F(ThreadPoolTest, KeyedTasksRunInOrder)
+{
+    constexpr int keyCount = 8;
+    constexpr int tasksPerKey = 2000;
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool threadPool(4, ThreadPoolOptions{mode});
+        std::array<std::vector<int>, keyCount> order;
+        std::array<std::atomic<int>, keyCount> running{};
+        std::atomic<int> overlaps{0};
+
+        std::vector<std::thread> producers;
+        for (int key = 0; key < keyCount; ++key)
+        {
+            producers.emplace_back(
+                [&, key]()
+                {
+                    for (int i = 0; i < tasksPerKey; ++i)
+                    {
+                        threadPool.postKeyed(key,
+                                             [&, key, i]()
+                                             {
+                                                 if (running[key]++ != 0)
+                                                     overlaps++;
+                                                 order[key].push_back(i);
+                                                 running[key]--;
+                                             });
+                    }
+                });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        EXPECT_EQ(threadPool.enqueueKeyed(std::string("last"), []() { return 7; }).get(), 7);
+        for (int key = 0; key < keyCount; ++key)
+        {
+            auto done = threadPool.enqueueKeyed(key, []() {});
+            done.get();
+            ASSERT_EQ(order[key].size(), static_cast<size_t>(tasksPerKey));
+            EXPECT_TRUE(std::ranges::is_sorted(order[key]));
+        }
+        EXPECT_EQ(overlaps, 0);
+    }
+
+    // 两个 Strand 的任务可以同时执行: 一个 Strand 阻塞时另一个仍能推进
+    ThreadPool threadPool(2);
+    Strand blocked(threadPool);
+    Strand free(threadPool);
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    blocked.post([gate]() { gate.wait(); });
+    auto blockedResult = blocked.enqueue([]() { return 1; });
+    int counter = 0;
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+    {
+        results.push_back(free.enqueue([&counter]() { return ++counter; }));
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(results[i].get(), i + 1);
+    }
+    EXPECT_EQ(blockedResult.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+    release.set_value();
+    EXPECT_EQ(blockedResult.get(), 1);
+}
+
+// 时间轮: 各层的定时器都在截止时间所在的推进步中触发, 不提前; 取消后不触发, 过期的 TimerId 无效
+TEST_F(ThreadPoolTest, TimerWheelCascades)
+{
+    const auto origin = std::chrono::steady_clock::now();
+    TimerWheel wheel(origin);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int64_t> deadlineDis(1, 20000000);
+    std::uniform_int_distribution<int64_t> stepDis(1, 5000);
+
+    constexpr size_t timerCount = 2000;
+    std::vector<int64_t> deadlines(timerCount);
+    std::vector<int64_t> firedAt(timerCount, -1);
+    std::vector<TimerId> ids(timerCount);
+    int64_t now = 0;
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        deadlines[i] = deadlineDis(gen);
+        ids[i] = wheel.add(origin + std::chrono::milliseconds(deadlines[i]), [&firedAt, &now, i]() { firedAt[i] = now; });
+    }
+    for (size_t i = 0; i < timerCount; i += 10)
+    {
+        EXPECT_TRUE(wheel.cancel(ids[i]));
+        EXPECT_FALSE(wheel.cancel(ids[i]));
+    }
+    EXPECT_EQ(wheel.size(), timerCount - timerCount / 10);
+
+    std::vector<UniqueTask> expired;
+    while (wheel.size() > 0)
+    {
+        ASSERT_LT(now, 30000000);
+        now += stepDis(gen);
+        wheel.advance(origin + std::chrono::milliseconds(now), expired);
+        for (auto& task : expired)
+        {
+            task();
+        }
+        expired.clear();
+    }
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        if (i % 10 == 0)
+        {
+            EXPECT_EQ(firedAt[i], -1);
+            continue;
+        }
+        EXPECT_GE(firedAt[i], deadlines[i]);
+        EXPECT_LE(firedAt[i], deadlines[i] + 5000);
+    }
+
+    // 下标复用后旧标识不能取消新定时器
+    TimerId reused = wheel.add(origin + std::chrono::milliseconds(now + 10), []() {});
+    EXPECT_FALSE(wheel.cancel(ids[0]));
+    EXPECT_TRUE(wheel.cancel(reused));
+}
+
+// 线程池定时任务: 延迟执行不提前, 可以取消, 周期任务反复执行直到取消, 析构时丢弃未到期的定时任务
+TEST_F(ThreadPoolTest, ScheduledTasks)
+{
+    ThreadPool threadPool(2);
+    const auto start = std::chrono::steady_clock::now();
+    std::promise<std::chrono::steady_clock::time_point> fired;
+    threadPool.scheduleAfter(std::chrono::milliseconds(30),
+                             [&fired]() { fired.set_value(std::chrono::steady_clock::now()); });
+    std::promise<int> atResult;
+    threadPool.scheduleAt(start + std::chrono::milliseconds(10), [&atResult](int value) { atResult.set_value(value); },
+                          7);
+    std::atomic<bool> cancelledRan{false};
+    TimerId cancelled = threadPool.scheduleAfter(std::chrono::milliseconds(20), [&]() { cancelledRan = true; });
+    EXPECT_TRUE(threadPool.cancelTimer(cancelled));
+
+    EXPECT_EQ(atResult.get_future().get(), 7);
+    EXPECT_GE(fired.get_future().get() - start, std::chrono::milliseconds(30));
+    EXPECT_FALSE(cancelledRan);
+    EXPECT_FALSE(threadPool.cancelTimer(cancelled));
+
+    std::atomic<int> ticks{0};
+    TimerId periodic = threadPool.scheduleEvery(std::chrono::milliseconds(2), [&ticks]() { ticks++; });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (ticks < 5 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(threadPool.cancelTimer(periodic));
+    EXPECT_GE(ticks.load(), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const int stopped = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(ticks.load(), stopped);
+
+    auto delayed = spawnAfter(threadPool, std::chrono::milliseconds(5), [](int value) { return value * 2; }, 21);
+    EXPECT_EQ(delayed.get(), 42);
+
+    {
+        ThreadPool shortLived(1);
+        std::atomic<bool> ran{false};
+        shortLived.scheduleAfter(std::chrono::hours(1), [&ran]() { ran = true; });
+        EXPECT_EQ(shortLived.getPendingTimers(), 1u);
+    }
+    EXPECT_THROW(threadPool.scheduleEvery(std::chrono::milliseconds(0), []() {}), std::invalid_argument);
+}
+
+// 协助等待: 工作线程等待同一线程池的结果时执行其它排队任务, 递归 fork/join 在线程数很少时也不会死锁
+TEST_F(ThreadPoolTest, HelpingWaitNestedForkJoin)
+{
+    for (auto mode : {SchedulingMode::SharedQueue, SchedulingMode::WorkStealing})
+    {
+        ThreadPool threadPool(2, ThreadPoolOptions{mode});
+        std::function<int(int)> fib = [&](int n) -> int
+        {
+            if (n < 2)
+                return n;
+            auto left = threadPool.enqueue(fib, n - 1);
+            const int right = fib(n - 2);
+            threadPool.wait(left);
+            return left.get() + right;
+        };
+        EXPECT_EQ(threadPool.enqueue(fib, 18).get(), 2584);
+
+        // TaskFuture 的 get() 在工作线程上同样会协助执行
+        ThreadPool single(1, ThreadPoolOptions{mode});
+        auto outer = spawn(single,
+                           [&single]()
+                           {
+                               auto inner = spawn(single, []() { return 20; });
+                               return inner.get() + 1;
+                           });
+        EXPECT_EQ(outer.get(), 21);
+    }
+
+    // 非工作线程直接阻塞等待
+    ThreadPool threadPool(1);
+    EXPECT_FALSE(threadPool.helpUntil([]() { return false; }));
+    auto result = threadPool.enqueue([]() { return 3; });
+    threadPool.wait(result);
+    EXPECT_EQ(result.get(), 3);
+}
+
+// 高/低优先级通道先计数再发布任务: 工作线程立即取走任务时排队计数也不会下溢, 有界队列不会误判为已满
+TEST_F(ThreadPoolTest, PriorityLaneCountsNeverUnderflow)
+{
+    ThreadPoolOptions options;
+    options.capacity = 64;
+    options.overflowPolicy = OverflowPolicy::Reject;
+    ThreadPool threadPool(ThreadCount, options);
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> maxObserved{0};
+    std::thread monitor(
+        [&]()
+        {
+            while (!done)
+            {
+                const size_t size = threadPool.getQueueSize();
+                if (size > maxObserved)
+                    maxObserved = size;
+            }
+        });
+
+    std::atomic<size_t> executed{0};
+    size_t rejected = 0;
+    for (int round = 0; round < 2000; ++round)
+    {
+        const TaskPriority priority = round % 2 == 0 ? TaskPriority::High : TaskPriority::Low;
+        try
+        {
+            threadPool.post(priority, [&executed]() { executed++; });
+        }
+        catch (const QueueFullError&)
+        {
+            rejected++;
+        }
+        while (executed < static_cast<size_t>(round + 1) - rejected)
+        {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    monitor.join();
+    EXPECT_EQ(rejected, 0u);
+    EXPECT_LE(maxObserved.load(), 1u);
+    EXPECT_EQ(threadPool.getQueueSize(), 0u);
+}
+
+// 被线程池丢弃的 spawn/then/TaskGraph 任务以 broken_promise 完成结果, 等待方不会永远阻塞
+TEST_F(ThreadPoolTest, DroppedTasksBreakTaskFutures)
+{
+    auto expectBroken = [](const auto& future)
+    {
+        ASSERT_TRUE(future.isReady());
+        try
+        {
+            future.get();
+            ADD_FAILURE() << "expected broken_promise";
+        }
+        catch (const std::future_error& e)
+        {
+            EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+        }
+    };
+
+    {
+        ThreadPoolOptions options;
+        options.capacity = 1;
+        options.overflowPolicy = OverflowPolicy::DropOldest;
+        ThreadPool threadPool(1, options);
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        threadPool.post(
+            [&]()
+            {
+                started = true;
+                while (!release)
+                {
+                    std::this_thread::yield();
+                }
+            });
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+
+        auto spawned = spawn(threadPool, []() { return 1; });
+        threadPool.post([]() {});
+        expectBroken(spawned);
+
+        TaskGraph graph;
+        auto first = graph.add([]() {});
+        auto second = graph.add([]() {});
+        graph.precede(first, second);
+        auto graphDone = graph.run(threadPool);
+        threadPool.post([]() {});
+        expectBroken(graphDone);
+        EXPECT_EQ(threadPool.getDroppedTasks(), 3u);
+        release = true;
+    }
+
+    {
+        TaskGraph graph;
+        graph.add([]() {});
+        ThreadPool threadPool(1);
+        auto ready = spawn(threadPool, []() { return 1; });
+        EXPECT_EQ(ready.get(), 1);
+        threadPool.post(
+            [&threadPool]()
+            {
+                while (!threadPool.getStopToken().stop_requested())
+                {
+                    std::this_thread::yield();
+                }
+            });
+        auto continued = ready.then([](int value) { return value + 1; });
+        auto spawned = spawn(threadPool, []() {});
+        auto graphDone = graph.run(threadPool);
+        EXPECT_GE(threadPool.shutdownNow(), 3u);
+        expectBroken(continued);
+        expectBroken(spawned);
+        expectBroken(graphDone);
+    }
+}
+
+// 有界模式下串行队列中积压的任务计入容量: Reject 拒绝新提交的任务, DropOldest 不丢弃已接受的任务,
+// CallerRuns 只在提交线程上执行一批, 其余交给工作线程; shutdownNow 丢弃串行队列中的任务并计入返回值
+TEST_F(ThreadPoolTest, KeyedTasksRespectBackpressure)
+{
+    auto occupy = [](ThreadPool& threadPool, std::atomic<bool>& release)
+    {
+        std::atomic<bool> started{false};
+        threadPool.post(
+            [&]()
+            {
+                started = true;
+                while (!release && !threadPool.getStopToken().stop_requested())
+                {
+                    std::this_thread::yield();
+                }
+            });
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    {
+        ThreadPoolOptions options;
+        options.capacity = 2;
+        options.overflowPolicy = OverflowPolicy::Reject;
+        ThreadPool threadPool(1, options);
+        std::atomic<bool> release{false};
+        occupy(threadPool, release);
+
+        auto first = threadPool.enqueueKeyed(0, []() { return 1; });
+        EXPECT_THROW(threadPool.enqueueKeyed(0, []() { return 2; }), QueueFullError);
+        EXPECT_THROW(threadPool.enqueueKeyed(1, []() { return 3; }), QueueFullError);
+        EXPECT_EQ(threadPool.getRejectedTasks(), 2u);
+        EXPECT_EQ(first.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+        release = true;
+        EXPECT_EQ(first.get(), 1);
+        EXPECT_EQ(threadPool.enqueueKeyed(0, []() { return 4; }).get(), 4);
+    }
+
+    {
+        ThreadPoolOptions options;
+        options.capacity = 1;
+        options.overflowPolicy = OverflowPolicy::DropOldest;
+        ThreadPool threadPool(1, options);
+        std::atomic<bool> release{false};
+        occupy(threadPool, release);
+
+        auto keyed = threadPool.enqueueKeyed(0, []() { return 1; });
+        auto plain = threadPool.enqueue([]() { return 2; });
+        auto later = threadPool.enqueue([]() { return 3; });
+        EXPECT_EQ(threadPool.getDroppedTasks(), 1u);
+        EXPECT_EQ(keyed.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+        release = true;
+        EXPECT_EQ(keyed.get(), 1);
+        EXPECT_THROW(plain.get(), std::future_error);
+        EXPECT_EQ(later.get(), 3);
+    }
+
+    {
+        ThreadPool threadPool(1);
+        std::atomic<bool> release{false};
+        occupy(threadPool, release);
+        auto first = threadPool.enqueueKeyed(0, []() {});
+        auto second = threadPool.enqueueKeyed(0, []() {});
+        EXPECT_EQ(threadPool.shutdownNow(), 2u);
+        for (auto* future : {&first, &second})
+        {
+            ASSERT_EQ(future->wait_for(std::chrono::seconds(0)), std::future_status::ready);
+            try
+            {
+                future->get();
+                ADD_FAILURE() << "expected broken_promise";
+            }
+            catch (const std::future_error& e)
+            {
+                EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+            }
+        }
+    }
+
+    {
+        constexpr int backlog = 4096;
+        ThreadPoolOptions options;
+        options.capacity = 1;
+        options.overflowPolicy = OverflowPolicy::CallerRuns;
+        ThreadPool threadPool(1, options);
+        std::atomic<bool> release{false};
+        occupy(threadPool, release);
+        threadPool.post([]() {});
+
+        // 队列已满, 提交线程负责调度时就地执行一批, 不会把整个积压的串行队列都留在提交线程上
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<int> executed{0};
+        std::atomic<int> inlined{0};
+        auto record = [&]()
+        {
+            if (std::this_thread::get_id() == caller)
+                inlined++;
+            executed++;
+        };
+        threadPool.postKeyed(0,
+                             [&]()
+                             {
+                                 for (int i = 0; i < backlog; ++i)
+                                 {
+                                     threadPool.postKeyed(0, record);
+                                 }
+                             });
+        EXPECT_GT(inlined.load(), 0);
+        EXPECT_LT(inlined.load(), backlog);
+        release = true;
+        while (executed < backlog)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// 队列已满时到期的定时任务仍然入队: Block 不会阻塞定时器线程而延迟其它定时器, CallerRuns 不会在定时器线程上执行
+TEST_F(ThreadPoolTest, TimersBypassFullQueue)
+{
+    for (OverflowPolicy policy : {OverflowPolicy::Block, OverflowPolicy::CallerRuns})
+    {
+        ThreadPoolOptions options;
+        options.capacity = 1;
+        options.overflowPolicy = policy;
+        ThreadPool threadPool(1, options);
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        std::thread::id worker;
+        threadPool.post(
+            [&]()
+            {
+                worker = std::this_thread::get_id();
+                started = true;
+                while (!release)
+                {
+                    std::this_thread::yield();
+                }
+            });
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+        threadPool.post([]() {});
+
+        std::mutex mutex;
+        std::vector<std::thread::id> fired;
+        auto record = [&]()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fired.push_back(std::this_thread::get_id());
+        };
+        threadPool.scheduleAfter(std::chrono::milliseconds(5), record);
+        threadPool.scheduleAfter(std::chrono::milliseconds(10), record);
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (threadPool.getQueueSize() < 3 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(threadPool.getQueueSize(), 3u);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            EXPECT_TRUE(fired.empty());
+        }
+
+        release = true;
+        EXPECT_EQ(threadPool.shutdown(std::chrono::seconds(5)), 0u);
+        ASSERT_EQ(fired.size(), 2u);
+        EXPECT_EQ(fired[0], worker);
+        EXPECT_EQ(fired[1], worker);
+    }
+}
+
+// 线程池停止时尚未到期的定时任务被析构: spawnAfter 的结果以 broken_promise 完成, 周期任务释放其捕获的资源
+TEST_F(ThreadPoolTest, StoppedTimersBreakDelayedFutures)
+{
+    auto resource = std::make_shared<int>(0);
+    auto threadPool = std::make_unique<ThreadPool>(2);
+    auto delayed = spawnAfter(*threadPool, std::chrono::hours(1), []() { return 1; });
+    auto continued = delayed.then([](int value) { return value + 1; });
+    threadPool->scheduleEvery(std::chrono::hours(1), [resource]() {});
+    EXPECT_EQ(threadPool->getPendingTimers(), 2u);
+    EXPECT_EQ(resource.use_count(), 2);
+
+    threadPool.reset();
+    EXPECT_EQ(resource.use_count(), 1);
+    for (const auto* future : {&delayed, &continued})
+    {
+        ASSERT_TRUE(future->isReady());
+        try
+        {
+            future->get();
+            ADD_FAILURE() << "expected broken_promise";
+        }
+        catch (const std::future_error& e)
+        {
+            EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+        }
+    }
+}
+
+// 协助等待在没有可执行任务时休眠并计为空闲线程, 等待的结果在其它线程上就绪或在线程池之外完成时都能返回
+TEST_F(ThreadPoolTest, HelpingWaitParksUntilReady)
+{
+    ThreadPool threadPool(2);
+    std::atomic<bool> release{false};
+    std::atomic<bool> innerStarted{false};
+    auto outer = spawn(threadPool,
+                       [&]()
+                       {
+                           auto inner = spawn(threadPool,
+                                              [&]()
+                                              {
+                                                  innerStarted = true;
+                                                  while (!release)
+                                                  {
+                                                      std::this_thread::yield();
+                                                  }
+                                                  return 1;
+                                              });
+                           return inner.get() + 1;
+                       });
+    while (!innerStarted)
+    {
+        std::this_thread::yield();
+    }
+    // 外层任务让出若干次后休眠, 此时只有内层任务计为活跃
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((threadPool.getActiveThreads() != 1 || threadPool.getIdleThreads() != 1) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(threadPool.getActiveThreads(), 1u);
+    EXPECT_EQ(threadPool.getIdleThreads(), 1u);
+    release = true;
+    EXPECT_EQ(outer.get(), 2);
+
+    // 等待目标在线程池之外完成 (其它线程设置的 promise) 时没有任何唤醒, 休眠上限保证等待方仍能返回
+    std::promise<int> external;
+    auto externalFuture = external.get_future();
+    auto waiter = threadPool.enqueue(
+        [&]()
+        {
+            threadPool.wait(externalFuture);
+            return externalFuture.get();
+        });
+    std::thread setter(
+        [&external]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            external.set_value(5);
+        });
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(waiter.get(), 5);
+    setter.join();
+}
+
+}  // namespace test
+}  // namespace threadpool
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Coroutine.hpp"
+#include "ParallelAlgorithms.hpp"
+#include "Strand.hpp"
+#include "TaskGraph.hpp"
+#include "TaskGroup.hpp"
+#include "ThreadPoolInvokeStrategy.hpp"
+#include "ThreadPool.hpp"
+
+namespace threadpool
+{
+namespace test
+{
+
+class ThreadPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override;
+    void TearDown() override;
+
+    static constexpr size_t ThreadCount = 4;
+};
+
+}  // namespace test
+}  // namespace threadpool
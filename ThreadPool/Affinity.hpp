@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <filesystem>
+#endif
+
+#if defined(THREADPOOL_HAS_LIBNUMA)
+#include <numa.h>
+#endif
+
+enum class AffinityMode
+{
+    None,             // 不绑定, 由操作系统调度
+    Compact,          // 依次占满一个插槽 (NUMA 节点) 的物理核再使用下一个, 共享缓存, 适合线程间频繁交换数据
+    Scatter,          // 轮流分布到各插槽的不同物理核上, 聚合内存带宽最高, 超线程兄弟核最后使用
+    NumaPartitioned,  // 按 NUMA 节点轮流分配工作线程, 绑定到节点内所有核心, 工作窃取时优先窃取同节点的队列
+};
+
+struct AffinityOptions
+{
+    AffinityMode mode = AffinityMode::None;
+    std::vector<int> cpus;  // 非空时只在这些逻辑 CPU 上分配工作线程
+};
+
+struct CpuInfo
+{
+    int cpu = 0;
+    int package = 0;
+    int core = 0;
+    int node = 0;
+};
+
+// 进程可用的逻辑 CPU 及其插槽/物理核/NUMA 节点. Linux 下读取 sysfs, 定义 THREADPOOL_HAS_LIBNUMA 时由 libnuma
+// 给出节点信息; 其它平台视为单节点, 绑定操作为空操作.
+class CpuTopology
+{
+public:
+    static const CpuTopology& instance()
+    {
+        static const CpuTopology topology;
+        return topology;
+    }
+
+    const std::vector<CpuInfo>& cpus() const
+    {
+        return cpuList;
+    }
+
+    size_t nodeCount() const
+    {
+        return nodes.size();
+    }
+
+    // 升序排列的节点编号
+    const std::vector<int>& nodeIds() const
+    {
+        return nodes;
+    }
+
+    int nodeOfCpu(int cpu) const
+    {
+        for (const auto& info : cpuList)
+        {
+            if (info.cpu == cpu)
+                return info.node;
+        }
+        return 0;
+    }
+
+    // 调用线程当前所在的 NUMA 节点, 无法获取时返回 -1
+    static int currentNode()
+    {
+#if defined(__linux__)
+        const int cpu = sched_getcpu();
+        if (cpu >= 0)
+            return instance().nodeOfCpu(cpu);
+#endif
+        return -1;
+    }
+
+private:
+    CpuTopology()
+    {
+#if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &allowed))
+                    cpuList.push_back(describe(cpu));
+            }
+        }
+#endif
+        if (cpuList.empty())
+        {
+            const int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+            for (int cpu = 0; cpu < count; ++cpu)
+            {
+                cpuList.push_back(CpuInfo{cpu, 0, cpu, 0});
+            }
+        }
+        for (const auto& info : cpuList)
+        {
+            if (std::find(nodes.begin(), nodes.end(), info.node) == nodes.end())
+                nodes.push_back(info.node);
+        }
+        std::sort(nodes.begin(), nodes.end());
+    }
+
+#if defined(__linux__)
+    static CpuInfo describe(int cpu)
+    {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuInfo info;
+        info.cpu = cpu;
+        info.package = readInt(base + "/topology/physical_package_id", 0);
+        info.core = readInt(base + "/topology/core_id", cpu);
+#if defined(THREADPOOL_HAS_LIBNUMA)
+        if (numa_available() >= 0)
+        {
+            info.node = std::max(0, numa_node_of_cpu(cpu));
+            return info;
+        }
+#endif
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(base, error))
+        {
+            const std::string name = entry.path().filename().string();
+            if (name.rfind("node", 0) == 0 && name.size() > 4)
+            {
+                info.node = std::atoi(name.c_str() + 4);
+                break;
+            }
+        }
+        return info;
+    }
+
+    static int readInt(const std::string& path, int fallback)
+    {
+        std::ifstream file(path);
+        int value = fallback;
+        if (file >> value)
+            return value;
+        return fallback;
+    }
+#endif
+
+    std::vector<CpuInfo> cpuList;
+    std::vector<int> nodes;
+};
+
+// 按策略为每个工作线程计算绑定的 CPU 集合与所属 NUMA 节点
+class AffinityPlan
+{
+public:
+    AffinityPlan(const AffinityOptions& options, size_t workerCount)
+        : mode(options.mode)
+    {
+        if (mode == AffinityMode::None || workerCount == 0)
+            return;
+
+        std::vector<CpuInfo> candidates;
+        for (const auto& info : CpuTopology::instance().cpus())
+        {
+            const bool listed = std::find(options.cpus.begin(), options.cpus.end(), info.cpu) != options.cpus.end();
+            if (options.cpus.empty() || listed)
+                candidates.push_back(info);
+        }
+        if (candidates.empty())
+        {
+            mode = AffinityMode::None;
+            return;
+        }
+
+        workerCpus.resize(workerCount);
+        workerNodes.resize(workerCount);
+        if (mode == AffinityMode::NumaPartitioned)
+        {
+            std::map<int, std::vector<int>> nodeCpus;
+            for (const auto& info : candidates)
+            {
+                nodeCpus[info.node].push_back(info.cpu);
+            }
+            std::vector<int> nodeOrder;
+            for (const auto& [node, cpus] : nodeCpus)
+            {
+                nodeOrder.push_back(node);
+            }
+            for (size_t worker = 0; worker < workerCount; ++worker)
+            {
+                const int node = nodeOrder[worker % nodeOrder.size()];
+                workerNodes[worker] = node;
+                workerCpus[worker] = nodeCpus[node];
+            }
+            return;
+        }
+
+        const std::vector<CpuInfo> order = mode == AffinityMode::Compact ? compactOrder(candidates)
+                                                                         : scatterOrder(candidates);
+        for (size_t worker = 0; worker < workerCount; ++worker)
+        {
+            const CpuInfo& info = order[worker % order.size()];
+            workerCpus[worker] = {info.cpu};
+            workerNodes[worker] = info.node;
+        }
+    }
+
+    bool enabled() const
+    {
+        return mode != AffinityMode::None;
+    }
+
+    bool partitioned() const
+    {
+        return mode == AffinityMode::NumaPartitioned;
+    }
+
+    const std::vector<int>& cpusOf(size_t worker) const
+    {
+        return workerCpus[worker];
+    }
+
+    int nodeOf(size_t worker) const
+    {
+        return enabled() ? workerNodes[worker] : 0;
+    }
+
+    // 在工作线程内调用, 把当前线程绑定到该工作线程的 CPU 集合
+    bool applyToCurrentThread(size_t worker) const
+    {
+        if (!enabled())
+            return false;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : workerCpus[worker])
+        {
+            CPU_SET(cpu, &set);
+        }
+        const bool bound = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#if defined(THREADPOOL_HAS_LIBNUMA)
+        // 绑定后首次访问的内存本就分配在本节点, 这里再把分配偏好设为本节点, 覆盖进程级的交错策略
+        if (bound && partitioned() && numa_available() >= 0)
+            numa_set_preferred(workerNodes[worker]);
+#endif
+        return bound;
+#else
+        return false;
+#endif
+    }
+
+private:
+    // 插槽 -> 物理核 -> 超线程, 相邻的工作线程共享同一个插槽的缓存
+    static std::vector<CpuInfo> compactOrder(std::vector<CpuInfo> cpus)
+    {
+        std::sort(cpus.begin(), cpus.end(),
+                  [](const CpuInfo& lhs, const CpuInfo& rhs)
+                  {
+                      return std::tie(lhs.node, lhs.package, lhs.core, lhs.cpu) <
+                             std::tie(rhs.node, rhs.package, rhs.core, rhs.cpu);
+                  });
+        return cpus;
+    }
+
+    // 先在各插槽间轮转, 每个物理核的第一个逻辑 CPU 都用完后才使用超线程兄弟核
+    static std::vector<CpuInfo> scatterOrder(const std::vector<CpuInfo>& cpus)
+    {
+        std::map<std::pair<int, int>, std::vector<std::vector<CpuInfo>>> packages;
+        std::map<std::tuple<int, int, int>, size_t> coreSlot;
+        for (const auto& info : compactOrder(cpus))
+        {
+            auto& cores = packages[{info.node, info.package}];
+            auto [it, inserted] = coreSlot.try_emplace({info.node, info.package, info.core}, cores.size());
+            if (inserted)
+                cores.emplace_back();
+            cores[it->second].push_back(info);
+        }
+
+        std::vector<CpuInfo> order;
+        for (size_t thread = 0; order.size() < cpus.size(); ++thread)
+        {
+            for (size_t core = 0;; ++core)
+            {
+                bool any = false;
+                for (auto& [key, cores] : packages)
+                {
+                    if (core < cores.size() && thread < cores[core].size())
+                    {
+                        order.push_back(cores[core][thread]);
+                        any = true;
+                    }
+                    any = any || core < cores.size();
+                }
+                if (!any)
+                    break;
+            }
+        }
+        return order;
+    }
+
+    AffinityMode mode;
+    std::vector<std::vector<int>> workerCpus;
+    std::vector<int> workerNodes;
+};
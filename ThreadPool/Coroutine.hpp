@@ -0,0 +1,299 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "TaskGraph.hpp"
+#include "ThreadPool.hpp"
+
+template<typename T = void>
+class Task;
+
+namespace threadpool::detail
+{
+
+class TaskPromiseBase
+{
+public:
+    // 协程结束时对称转移到等待者, 不增加调用栈深度
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        error = std::current_exception();
+    }
+
+    void setContinuation(std::coroutine_handle<> handle) noexcept
+    {
+        continuation = handle;
+    }
+
+protected:
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    Task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        result.emplace(std::forward<U>(value));
+    }
+
+    T takeResult()
+    {
+        if (error)
+            std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+private:
+    std::optional<T> result;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void takeResult()
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
+
+}  // namespace threadpool::detail
+
+// 惰性启动的协程任务: 被 co_await 或交给 spawn() 时才开始执行, 结束后恢复等待者.
+// 协程在哪个线程上恢复由其内部等待的对象决定, 等待 pool.schedule() 或 TaskFuture 后在线程池工作线程上继续.
+template<typename T>
+class [[nodiscard]] Task
+{
+public:
+    using promise_type = threadpool::detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : handle(handle)
+    {
+    }
+
+    Task(Task&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept
+            {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().setContinuation(awaiting);
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().takeResult();
+            }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+Task<T> threadpool::detail::TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> threadpool::detail::TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+// co_await TaskFuture: 结果就绪前挂起, 就绪后在该结果所属的线程池上恢复, 返回值与 get() 相同
+template<typename T>
+auto operator co_await(const TaskFuture<T>& future)
+{
+    struct Awaiter
+    {
+        TaskFuture<T> future;
+
+        bool await_ready() const
+        {
+            return future.isReady();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            const auto& state = threadpool::detail::TaskFutureAccess::state(future);
+            state->onReady(
+                [pool = state->getPool(), handle]()
+                {
+                    if (pool == nullptr)
+                    {
+                        handle.resume();
+                        return;
+                    }
+                    try
+                    {
+                        pool->post([handle]() { handle.resume(); });
+                    }
+                    catch (const std::exception&)
+                    {
+                        // 线程池已停止, 在完成结果的线程上恢复
+                        handle.resume();
+                    }
+                });
+        }
+
+        decltype(auto) await_resume() const
+        {
+            return future.get();
+        }
+    };
+    return Awaiter{future};
+}
+
+namespace threadpool::detail
+{
+
+// 自行销毁的协程, 只用于把 Task 挂到线程池上运行
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+template<typename T>
+DetachedCoroutine runOnPool(ThreadPool& pool, Task<T> task, std::shared_ptr<TaskState<T>> state)
+{
+    std::exception_ptr error;
+    std::optional<typename TaskState<T>::Storage> result;
+    try
+    {
+        co_await pool.schedule();
+        if constexpr (std::is_void_v<T>)
+        {
+            co_await std::move(task);
+            result.emplace();
+        }
+        else
+        {
+            result.emplace(co_await std::move(task));
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (error)
+        state->setException(std::move(error));
+    else if constexpr (std::is_void_v<T>)
+        state->setValue();
+    else
+        state->setValue(std::move(*result));
+}
+
+}  // namespace threadpool::detail
+
+// 在线程池工作线程上启动协程任务, 返回可等待或挂接后续任务的 TaskFuture
+template<typename T>
+TaskFuture<T> spawn(ThreadPool& pool, Task<T> task)
+{
+    auto state = std::make_shared<threadpool::detail::TaskState<T>>(&pool);
+    threadpool::detail::runOnPool(pool, std::move(task), state);
+    return TaskFuture<T>(std::move(state));
+}
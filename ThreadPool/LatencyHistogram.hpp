@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// 延迟统计结果, 时间单位均为纳秒
+struct LatencySummary
+{
+    uint64_t count = 0;
+    double mean = 0.0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+};
+
+// HDR 风格的对数线性直方图: 每个 2 的幂区间再均分为 16 个子桶, 相对误差约 6%.
+// 所有计数器都是原子变量, record 只做 relaxed 原子加, 不加锁; 读取时由 HistogramSnapshot 合并各分片.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SubBucketBits = 4;
+    static constexpr uint64_t SubBucketCount = uint64_t{1} << SubBucketBits;
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    static constexpr size_t bucketIndex(uint64_t value) noexcept
+    {
+        if (value < SubBucketCount)
+            return static_cast<size_t>(value);
+        const unsigned exponent = 63 - static_cast<unsigned>(std::countl_zero(value));
+        const uint64_t subBucket = (value >> (exponent - SubBucketBits)) & (SubBucketCount - 1);
+        return static_cast<size_t>((exponent - SubBucketBits + 1) * SubBucketCount + subBucket);
+    }
+
+    // 桶内数值范围的中点, 用于估算分位数
+    static constexpr uint64_t bucketValue(size_t index) noexcept
+    {
+        if (index < SubBucketCount)
+            return index;
+        const unsigned exponent = static_cast<unsigned>(index / SubBucketCount) + SubBucketBits - 1;
+        const uint64_t subBucket = index % SubBucketCount;
+        const uint64_t width = uint64_t{1} << (exponent - SubBucketBits);
+        return ((SubBucketCount + subBucket) << (exponent - SubBucketBits)) + width / 2;
+    }
+
+    void record(uint64_t value) noexcept
+    {
+        buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current = minValue.load(std::memory_order_relaxed);
+        while (value < current && !minValue.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+        current = maxValue.load(std::memory_order_relaxed);
+        while (value > current && !maxValue.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void reset() noexcept
+    {
+        for (auto& bucket : buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        minValue.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    friend class HistogramSnapshot;
+
+    std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> minValue{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> maxValue{0};
+};
+
+// 合并多个分片后的只读快照
+class HistogramSnapshot
+{
+public:
+    void merge(const LatencyHistogram& histogram) noexcept
+    {
+        for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+        {
+            buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+        }
+        count += histogram.count.load(std::memory_order_relaxed);
+        sum += histogram.sum.load(std::memory_order_relaxed);
+        minValue = std::min(minValue, histogram.minValue.load(std::memory_order_relaxed));
+        maxValue = std::max(maxValue, histogram.maxValue.load(std::memory_order_relaxed));
+    }
+
+    uint64_t percentile(double quantile) const noexcept
+    {
+        if (count == 0)
+            return 0;
+        const auto rank = static_cast<uint64_t>(quantile * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+                return std::clamp(LatencyHistogram::bucketValue(i), minValue, maxValue);
+        }
+        return maxValue;
+    }
+
+    LatencySummary summary() const noexcept
+    {
+        LatencySummary result;
+        if (count == 0)
+            return result;
+        result.count = count;
+        result.mean = static_cast<double>(sum) / static_cast<double>(count);
+        result.min = minValue;
+        result.max = maxValue;
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.p999 = percentile(0.999);
+        return result;
+    }
+
+private:
+    std::array<uint64_t, LatencyHistogram::BucketCount> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t minValue = std::numeric_limits<uint64_t>::max();
+    uint64_t maxValue = 0;
+};
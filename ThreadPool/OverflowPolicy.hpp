@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+// 有界队列已满时对新任务的处理方式
+enum class OverflowPolicy
+{
+    Block,       // 阻塞提交线程直到有空位; 在工作线程内提交时改为由提交线程直接执行, 避免工作线程互相等待而死锁
+    Reject,      // 抛出 QueueFullError, 任务不入队
+    DropOldest,  // 丢弃最早排队的任务为新任务腾出位置, 被丢弃任务的 future 得到 broken_promise
+    CallerRuns,  // 由提交线程直接执行新任务, 自然降低提交速度
+};
+
+class QueueFullError : public std::runtime_error
+{
+public:
+    explicit QueueFullError(const std::string& message)
+        : std::runtime_error(message)
+    {
+    }
+};
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+enum class Partitioner
+{
+    Static,    // 预先均分为 (线程数 + 1) 块, 调用线程也领取一块
+    Adaptive,  // 惰性二分: 线程池没有排队任务时才把剩余区间对半拆出去, 最小粒度为 grainSize
+};
+
+struct ParallelOptions
+{
+    Partitioner partitioner = Partitioner::Adaptive;
+    size_t grainSize = 0;  // 0 表示根据元素数和线程数自动选择
+};
+
+namespace threadpool::detail
+{
+
+// 一次并行调用的共享状态. 待处理区间放在状态内部的栈里, 投递到线程池的只是"帮手"任务:
+// 帮手和调用线程都从栈中领取区间, 调用线程在等待期间也会继续领取, 因此嵌套调用不会死锁.
+// 帮手任务可能在调用返回后才开始执行, 此时栈已为空, 不会再访问 body.
+template<typename Body>
+class ParallelRange : public std::enable_shared_from_this<ParallelRange<Body>>
+{
+public:
+    ParallelRange(ThreadPool& pool, Body& body, size_t count, size_t grain, bool adaptive)
+        : pool(pool)
+        , body(body)
+        , grain(grain)
+        , adaptive(adaptive)
+        , remaining(count)
+    {
+    }
+
+    void run(size_t count, size_t chunks)
+    {
+        const size_t chunkSize = (count + chunks - 1) / chunks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t begin = 0; begin < count; begin += chunkSize)
+            {
+                pending.emplace_back(begin, std::min(count, begin + chunkSize));
+            }
+        }
+        for (size_t i = 1; i < chunks; ++i)
+        {
+            spawnHelper();
+        }
+
+        while (true)
+        {
+            const uint64_t seen = signal.load();
+            std::pair<size_t, size_t> range;
+            if (popRange(range))
+            {
+                process(range.first, range.second);
+                continue;
+            }
+            if (remaining.load() == 0)
+                break;
+            signal.wait(seen);
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    void spawnHelper()
+    {
+        try
+        {
+            pool.post(
+                [self = this->shared_from_this()]()
+                {
+                    std::pair<size_t, size_t> range;
+                    while (self->popRange(range))
+                    {
+                        self->process(range.first, range.second);
+                    }
+                });
+        }
+        catch (const std::exception&)
+        {
+            // 线程池已停止时由调用线程独自完成剩余区间
+        }
+    }
+
+    bool popRange(std::pair<size_t, size_t>& range)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty())
+            return false;
+        range = pending.back();
+        pending.pop_back();
+        return true;
+    }
+
+    void pushRange(size_t begin, size_t end)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.emplace_back(begin, end);
+        }
+        signal.fetch_add(1);
+        signal.notify_all();
+        spawnHelper();
+    }
+
+    void process(size_t begin, size_t end)
+    {
+        while (begin < end)
+        {
+            if (adaptive && end - begin > grain && pool.getQueueSize() == 0)
+            {
+                const size_t middle = begin + (end - begin) / 2;
+                pushRange(middle, end);
+                end = middle;
+                continue;
+            }
+
+            const size_t chunkEnd = std::min(end, begin + grain);
+            if (!failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    body(begin, chunkEnd);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    failed = true;
+                }
+            }
+            complete(chunkEnd - begin);
+            begin = chunkEnd;
+        }
+    }
+
+    void complete(size_t count)
+    {
+        if (remaining.fetch_sub(count) == count)
+        {
+            signal.fetch_add(1);
+            signal.notify_all();
+        }
+    }
+
+    ThreadPool& pool;
+    Body& body;
+    const size_t grain;
+    const bool adaptive;
+
+    std::mutex mutex;
+    std::vector<std::pair<size_t, size_t>> pending;
+    std::atomic<size_t> remaining;
+    std::atomic<uint64_t> signal{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+};
+
+// 以 [0, count) 下标区间为单位的并行执行入口, body(begin, end) 处理一个连续子区间
+template<typename Body>
+void parallelChunks(ThreadPool& pool, size_t count, const ParallelOptions& options, Body&& body)
+{
+    if (count == 0)
+        return;
+
+    const size_t participants = pool.getThreadCount() + 1;
+    const bool adaptive = options.partitioner == Partitioner::Adaptive;
+    size_t grain = options.grainSize;
+    if (grain == 0)
+        grain = adaptive ? std::max<size_t>(1, count / (participants * 32)) : (count + participants - 1) / participants;
+
+    const size_t chunks = adaptive ? 1 : std::max<size_t>(1, std::min(participants, (count + grain - 1) / grain));
+    auto range = std::make_shared<ParallelRange<std::remove_reference_t<Body>>>(pool, body, count, grain, adaptive);
+    range->run(count, chunks);
+}
+
+}  // namespace threadpool::detail
+
+// 对 [first, last) 中每个下标调用 f(i)
+template<std::integral Index, typename F>
+void parallelFor(ThreadPool& pool, Index first, Index last, F&& f, const ParallelOptions& options = {})
+{
+    if (last <= first)
+        return;
+    threadpool::detail::parallelChunks(pool, static_cast<size_t>(last - first), options,
+                                       [&](size_t begin, size_t end)
+                                       {
+                                           for (size_t i = begin; i < end; ++i)
+                                           {
+                                               f(static_cast<Index>(first + static_cast<Index>(i)));
+                                           }
+                                       });
+}
+
+// 对 [first, last) 中每个元素调用 f(*it)
+template<std::random_access_iterator Iterator, typename F>
+void parallelFor(ThreadPool& pool, Iterator first, Iterator last, F&& f, const ParallelOptions& options = {})
+{
+    threadpool::detail::parallelChunks(pool, static_cast<size_t>(std::distance(first, last)), options,
+                                       [&](size_t begin, size_t end)
+                                       {
+                                           for (auto it = first + begin; it != first + end; ++it)
+                                           {
+                                               f(*it);
+                                           }
+                                       });
+}
+
+// 并行归约, 与 std::reduce 一样要求 op 满足结合律和交换律
+template<std::random_access_iterator Iterator, typename T, typename BinaryOp = std::plus<>>
+T parallelReduce(ThreadPool& pool, Iterator first, Iterator last, T init, BinaryOp op = {},
+                 const ParallelOptions& options = {})
+{
+    std::mutex resultMutex;
+    std::optional<T> result;
+    threadpool::detail::parallelChunks(pool, static_cast<size_t>(std::distance(first, last)), options,
+                                       [&](size_t begin, size_t end)
+                                       {
+                                           T partial = first[begin];
+                                           for (size_t i = begin + 1; i < end; ++i)
+                                           {
+                                               partial = op(std::move(partial), first[i]);
+                                           }
+                                           std::lock_guard<std::mutex> lock(resultMutex);
+                                           result = result ? op(std::move(*result), std::move(partial))
+                                                           : std::move(partial);
+                                       });
+    return result ? op(std::move(init), std::move(*result)) : init;
+}
+
+// 并行变换, 等价于 std::transform, 返回输出区间的末尾
+template<std::random_access_iterator InputIterator, std::random_access_iterator OutputIterator, typename UnaryOp>
+OutputIterator parallelTransform(ThreadPool& pool, InputIterator first, InputIterator last, OutputIterator out,
+                                 UnaryOp op, const ParallelOptions& options = {})
+{
+    const auto count = std::distance(first, last);
+    threadpool::detail::parallelChunks(pool, static_cast<size_t>(count), options,
+                                       [&](size_t begin, size_t end)
+                                       { std::transform(first + begin, first + end, out + begin, op); });
+    return out + count;
+}
+
+// 并行包含式前缀和, 等价于 std::inclusive_scan. 两遍扫描: 先并行求各块之和, 串行求块前缀,
+// 再并行带进位扫描各块. 块划分固定, options 只影响每遍内部的调度方式.
+template<std::random_access_iterator InputIterator, std::random_access_iterator OutputIterator,
+         typename BinaryOp = std::plus<>>
+OutputIterator parallelScan(ThreadPool& pool, InputIterator first, InputIterator last, OutputIterator out,
+                            BinaryOp op = {}, const ParallelOptions& options = {})
+{
+    using value_type = typename std::iterator_traits<InputIterator>::value_type;
+
+    const auto count = static_cast<size_t>(std::distance(first, last));
+    if (count == 0)
+        return out;
+
+    const size_t blocks = std::min(count, (pool.getThreadCount() + 1) * 4);
+    const size_t blockSize = (count + blocks - 1) / blocks;
+    const size_t blockCount = (count + blockSize - 1) / blockSize;
+
+    std::vector<std::optional<value_type>> blockSums(blockCount);
+    ParallelOptions blockOptions = options;
+    blockOptions.grainSize = 1;
+    threadpool::detail::parallelChunks(pool, blockCount, blockOptions,
+                                       [&](size_t beginBlock, size_t endBlock)
+                                       {
+                                           for (size_t block = beginBlock; block < endBlock; ++block)
+                                           {
+                                               const size_t begin = block * blockSize;
+                                               const size_t end = std::min(count, begin + blockSize);
+                                               value_type sum = first[begin];
+                                               for (size_t i = begin + 1; i < end; ++i)
+                                               {
+                                                   sum = op(std::move(sum), first[i]);
+                                               }
+                                               blockSums[block] = std::move(sum);
+                                           }
+                                       });
+
+    // blockSums[i] 变为第 i 块之前所有元素的和 (第 0 块没有进位)
+    std::optional<value_type> carry;
+    for (auto& blockSum : blockSums)
+    {
+        std::optional<value_type> next = carry ? op(*carry, *blockSum) : *blockSum;
+        blockSum = carry;
+        carry = std::move(next);
+    }
+
+    threadpool::detail::parallelChunks(pool, blockCount, blockOptions,
+                                       [&](size_t beginBlock, size_t endBlock)
+                                       {
+                                           for (size_t block = beginBlock; block < endBlock; ++block)
+                                           {
+                                               const size_t begin = block * blockSize;
+                                               const size_t end = std::min(count, begin + blockSize);
+                                               if (blockSums[block])
+                                                   std::inclusive_scan(first + begin, first + end, out + begin, op,
+                                                                       *blockSums[block]);
+                                               else
+                                                   std::inclusive_scan(first + begin, first + end, out + begin, op);
+                                           }
+                                       });
+    return out + count;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "RingDeque.hpp"
+
+enum class TaskPriority
+{
+    High,    // 优先于普通任务执行, 按截止时间最早优先 (EDF) 排序
+    Normal,  // 默认通道, 走线程池原有的共享队列或工作窃取队列
+    Low,     // 后台任务, 只在没有普通任务时执行, 等待超过老化阈值后排到普通任务之前
+};
+
+// 高优先级/截止时间通道与低优先级通道. 高优先级任务视为截止时间等于提交时间的 EDF 任务.
+// 低优先级任务等待超过老化阈值后排到普通任务之前, 并且紧急任务每连续执行 UrgentBurst 个
+// 就让出一次给老化的低优先级任务, 保证后台任务在紧急任务打满时也能前进.
+// T 需要提供 enqueueTime 成员.
+template<typename T>
+class PriorityLanes
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t UrgentBurst = 16;
+
+    explicit PriorityLanes(Clock::duration agingThreshold)
+        : agingThreshold(agingThreshold)
+    {
+    }
+
+    void pushUrgent(T task, Clock::time_point deadline)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        urgent.push_back(UrgentEntry{deadline, nextSequence++, std::move(task)});
+        std::push_heap(urgent.begin(), urgent.end(), laterDeadline);
+        // 在锁内计数, 取任务的一方在同一把锁下减计数, 计数不会先减后增而下溢
+        count.fetch_add(1);
+    }
+
+    void pushLow(T task)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        low.push_back(std::move(task));
+        count.fetch_add(1);
+    }
+
+    // 取截止时间最早的紧急任务, 或已经超过老化阈值的低优先级任务
+    bool tryPopUrgent(T& task, Clock::time_point now)
+    {
+        if (count.load(std::memory_order_relaxed) == 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool lowAged = !low.empty() && low.front().enqueueTime + agingThreshold <= now;
+        if (lowAged && (urgent.empty() || urgentStreak >= UrgentBurst))
+        {
+            popLow(task);
+            return true;
+        }
+        if (urgent.empty())
+            return false;
+
+        std::pop_heap(urgent.begin(), urgent.end(), laterDeadline);
+        task = std::move(urgent.back().task);
+        urgent.pop_back();
+        count.fetch_sub(1);
+        ++urgentStreak;
+        return true;
+    }
+
+    bool tryPopLow(T& task)
+    {
+        if (count.load(std::memory_order_relaxed) == 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (low.empty())
+            return false;
+        popLow(task);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return count.load();
+    }
+
+private:
+    struct UrgentEntry
+    {
+        Clock::time_point deadline;
+        uint64_t sequence;
+        T task;
+    };
+
+    // 小顶堆比较器: 截止时间相同则先提交的先执行
+    static bool laterDeadline(const UrgentEntry& lhs, const UrgentEntry& rhs)
+    {
+        if (lhs.deadline != rhs.deadline)
+            return lhs.deadline > rhs.deadline;
+        return lhs.sequence > rhs.sequence;
+    }
+
+    void popLow(T& task)
+    {
+        task = std::move(low.front());
+        low.pop_front();
+        count.fetch_sub(1);
+        urgentStreak = 0;
+    }
+
+    const Clock::duration agingThreshold;
+    mutable std::mutex mutex;
+    std::vector<UrgentEntry> urgent;
+    RingDeque<T> low;
+    uint64_t nextSequence = 0;
+    size_t urgentStreak = 0;
+    std::atomic<size_t> count{0};
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 基于环形缓冲区的双端队列: 容量按 2 的幂增长且不回收,
+// 稳定运行后入队出队不再产生堆分配 (std::deque 每 512 字节就要分配/释放一个块).
+template<typename T>
+class RingDeque
+{
+public:
+    explicit RingDeque(size_t initialCapacity = 64)
+    {
+        size_t capacity = 1;
+        while (capacity < initialCapacity)
+            capacity <<= 1;
+        buffer.resize(capacity);
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    void push_back(T item)
+    {
+        if (count == buffer.size())
+            grow();
+        buffer[(head + count) & (buffer.size() - 1)] = std::move(item);
+        ++count;
+    }
+
+    T& front()
+    {
+        return buffer[head];
+    }
+
+    T& back()
+    {
+        return buffer[(head + count - 1) & (buffer.size() - 1)];
+    }
+
+    void pop_front()
+    {
+        buffer[head] = T();
+        head = (head + 1) & (buffer.size() - 1);
+        --count;
+    }
+
+    void pop_back()
+    {
+        back() = T();
+        --count;
+    }
+
+private:
+    void grow()
+    {
+        std::vector<T> larger(buffer.size() * 2);
+        for (size_t i = 0; i < count; ++i)
+        {
+            larger[i] = std::move(buffer[(head + i) & (buffer.size() - 1)]);
+        }
+        buffer.swap(larger);
+        head = 0;
+    }
+
+    std::vector<T> buffer;
+    size_t head = 0;
+    size_t count = 0;
+};
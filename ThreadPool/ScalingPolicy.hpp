@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// 弹性线程池做扩缩容决策时的输入
+struct ScalingMetrics
+{
+    size_t threadCount = 0;
+    size_t minThreads = 0;
+    size_t maxThreads = 0;
+    size_t idleThreads = 0;
+    size_t activeThreads = 0;
+    size_t queueDepth = 0;
+    std::chrono::nanoseconds recentQueueWait{0};  // 各工作线程最近一次取到任务时的排队时间的最大值
+};
+
+class IScalingPolicy
+{
+public:
+    virtual ~IScalingPolicy() = default;
+
+    // 提交任务时发现排队任务多于空闲线程才会调用, 返回 true 则新增一个工作线程
+    virtual bool shouldGrow(const ScalingMetrics& metrics) = 0;
+
+    // 工作线程空闲超时后调用, 返回 true 则该线程退出
+    virtual bool shouldRetire(const ScalingMetrics& metrics) = 0;
+};
+
+// 默认策略: 空闲线程消化不了的排队任务数或排队时间超过阈值时扩容, 空闲超时即缩容
+class ThresholdScalingPolicy : public IScalingPolicy
+{
+public:
+    explicit ThresholdScalingPolicy(size_t queueDepthThreshold = 4,
+                                    std::chrono::nanoseconds queueWaitThreshold = std::chrono::milliseconds(1))
+        : queueDepthThreshold(queueDepthThreshold)
+        , queueWaitThreshold(queueWaitThreshold)
+    {
+    }
+
+    bool shouldGrow(const ScalingMetrics& metrics) override
+    {
+        if (metrics.threadCount >= metrics.maxThreads)
+            return false;
+        return metrics.queueDepth > metrics.idleThreads + queueDepthThreshold ||
+               (metrics.idleThreads == 0 && metrics.recentQueueWait > queueWaitThreshold);
+    }
+
+    bool shouldRetire(const ScalingMetrics& metrics) override
+    {
+        return metrics.threadCount > metrics.minThreads;
+    }
+
+private:
+    size_t queueDepthThreshold;
+    std::chrono::nanoseconds queueWaitThreshold;
+};
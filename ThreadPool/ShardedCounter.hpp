@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+// 按线程分片的计数器: 每个分片独占一条缓存行, 工作线程只写自己的分片, 池外线程共用最后一个分片, 读取时对所有分片求和.
+// 同一个任务可能在一个分片上计入, 在另一个分片上减去, 单个分片会回绕, 按模求和仍然正确;
+// 求和期间有并发修改时结果可能短暂为负, 此时按 0 返回
+class ShardedCounter
+{
+public:
+    explicit ShardedCounter(size_t shardCount)
+        : shardCount(shardCount)
+        , shards(std::make_unique<Shard[]>(shardCount))
+    {
+    }
+
+    void add(size_t shard, size_t count = 1)
+    {
+        shards[shard].value.fetch_add(count);
+    }
+
+    void sub(size_t shard, size_t count = 1)
+    {
+        shards[shard].value.fetch_sub(count);
+    }
+
+    size_t load() const
+    {
+        size_t sum = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            sum += shards[i].value.load();
+        }
+        return sum > std::numeric_limits<size_t>::max() / 2 ? 0 : sum;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<size_t> value{0};
+    };
+
+    const size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+// 串行执行器: 通过同一个 Strand 提交的任务按提交顺序依次执行, 不会并发, 因此这些任务访问的状态不需要加锁.
+// 不同 Strand 的任务在线程池上并行执行. 每个 Strand 持有一个进程内唯一的 key, 提交转发给 ThreadPool::postKeyed
+class Strand
+{
+public:
+    explicit Strand(ThreadPool& pool)
+        : pool(pool)
+        , key(nextKey.fetch_add(1, std::memory_order_relaxed))
+    {
+    }
+
+    template<typename F, typename... Args>
+    auto enqueue(F&& f, Args&&... args)
+    {
+        return pool.enqueueKeyed(key, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template<typename F, typename... Args>
+    void post(F&& f, Args&&... args)
+    {
+        pool.postKeyed(key, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    ThreadPool& getThreadPool() const
+    {
+        return pool;
+    }
+
+private:
+    inline static std::atomic<size_t> nextKey{0};
+
+    ThreadPool& pool;
+    const size_t key;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+
+#include "UniqueTask.hpp"
+
+// 串行执行队列: 任意线程 push, 同一时刻最多一个线程 drain, 任务按 push 顺序依次执行.
+// 入队是 Vyukov 的无锁 MPSC 链表, 提交方只做一次原子交换; pending 计数从 0 变为 1 的提交方负责调度一次 drain,
+// drain 执行到计数归零为止, 因此不需要锁也不会有两个线程同时执行同一个队列的任务.
+class StrandQueue
+{
+public:
+    StrandQueue()
+        : head(&stub)
+        , tail(&stub)
+    {
+    }
+
+    StrandQueue(const StrandQueue&) = delete;
+    StrandQueue& operator=(const StrandQueue&) = delete;
+
+    ~StrandQueue()
+    {
+        Node* node = tail->next.load(std::memory_order_relaxed);
+        while (node != nullptr)
+        {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+        if (tail != &stub)
+            delete tail;
+    }
+
+    // 返回 true 表示队列此前为空, 调用方需要调度一次 drain
+    bool push(UniqueTask task)
+    {
+        Node* node = new Node(std::move(task));
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+        return pending.fetch_add(1, std::memory_order_acq_rel) == 0;
+    }
+
+    // 按顺序执行最多 budget 个任务, executed 返回执行的任务数. 返回 true 表示还有任务, 调用方需要再调度一次 drain;
+    // 分批执行让同一工作线程上的其它任务有机会运行
+    bool drain(size_t budget, size_t& executed)
+    {
+        for (executed = 0; executed < budget;)
+        {
+            UniqueTask task = popTask();
+            try
+            {
+                task();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Exception in ThreadPool strand task: " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << "Unknown exception in ThreadPool strand task" << std::endl;
+            }
+            task.reset();
+            ++executed;
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                return false;
+        }
+        return true;
+    }
+
+    // 丢弃排队的任务而不执行, 直到计数归零. 与 drain 一样只能由负责该队列的线程调用, 返回丢弃的任务数
+    size_t discard()
+    {
+        size_t discarded = 0;
+        do
+        {
+            popTask().reset();
+            ++discarded;
+        } while (pending.fetch_sub(1, std::memory_order_acq_rel) != 1);
+        return discarded;
+    }
+
+    size_t size() const
+    {
+        return pending.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+
+        explicit Node(UniqueTask task)
+            : task(std::move(task))
+        {
+        }
+
+        std::atomic<Node*> next{nullptr};
+        UniqueTask task;
+    };
+
+    // 只由 drain 的线程调用. pending 保证至少有一个已入队的节点, 提交方在交换 head 与链接 next 之间被抢占时短暂等待
+    UniqueTask popTask()
+    {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        while (next == nullptr)
+        {
+            std::this_thread::yield();
+            next = tail->next.load(std::memory_order_acquire);
+        }
+        // next 成为新的哨兵节点, 取走它的任务后释放旧哨兵
+        Node* previous = tail;
+        tail = next;
+        UniqueTask task = std::move(next->task);
+        if (previous != &stub)
+            delete previous;
+        return task;
+    }
+
+    alignas(64) std::atomic<Node*> head;
+    alignas(64) Node* tail;
+    std::atomic<size_t> pending{0};
+    Node stub;
+};
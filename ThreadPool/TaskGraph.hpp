@@ -0,0 +1,768 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "UniqueTask.hpp"
+
+template<typename T>
+class TaskFuture;
+
+namespace threadpool::detail
+{
+
+// 异步结果的共享状态. 完成回调在完成结果的线程上直接调用, 只做计数或投递, 不执行用户代码.
+// 结果只能写入一次, 之后的 setValue/setException 被忽略
+class TaskStateBase
+{
+public:
+    explicit TaskStateBase(ThreadPool* pool)
+        : pool(pool)
+    {
+    }
+
+    virtual ~TaskStateBase() = default;
+
+    bool isReady() const
+    {
+        return ready.load(std::memory_order_acquire);
+    }
+
+    // 在所属线程池的工作线程上等待时执行其它排队任务, 见 ThreadPool::helpUntil
+    void wait()
+    {
+        if (isReady())
+            return;
+        if (pool)
+            pool->helpUntil([this] { return isReady(); });
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return ready.load(std::memory_order_acquire); });
+    }
+
+    // 已经完成时在当前线程立即调用
+    void onReady(UniqueTask callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ready.load(std::memory_order_relaxed))
+            {
+                callbacks.push_back(std::move(callback));
+                return;
+            }
+        }
+        callback();
+    }
+
+    void setException(std::exception_ptr exception)
+    {
+        if (!claim())
+            return;
+        error = std::move(exception);
+        complete();
+    }
+
+    const std::exception_ptr& exception() const
+    {
+        return error;
+    }
+
+    ThreadPool* getPool() const
+    {
+        return pool;
+    }
+
+protected:
+    // 取得写入结果的权利, 只有第一个调用者返回 true
+    bool claim()
+    {
+        return !claimed.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void complete()
+    {
+        std::vector<UniqueTask> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.store(true, std::memory_order_release);
+            pending.swap(callbacks);
+        }
+        condition.notify_all();
+        if (pool)
+            pool->notifyHelpers();
+        for (auto& callback : pending)
+        {
+            callback();
+        }
+    }
+
+private:
+    ThreadPool* const pool;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> claimed{false};
+    std::atomic<bool> ready{false};
+    std::vector<UniqueTask> callbacks;
+    std::exception_ptr error;
+};
+
+template<typename T>
+class TaskState : public TaskStateBase
+{
+public:
+    using Storage = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    using TaskStateBase::TaskStateBase;
+
+    template<typename... Args>
+    void setValue(Args&&... args)
+    {
+        if (!claim())
+            return;
+        result.emplace(std::forward<Args>(args)...);
+        complete();
+    }
+
+    const Storage& value() const
+    {
+        return *result;
+    }
+
+private:
+    std::optional<Storage> result;
+};
+
+// 执行 func 并把返回值或异常写入 state
+template<typename T, typename F>
+void fulfil(TaskState<T>& state, F&& func)
+{
+    if constexpr (std::is_void_v<T>)
+    {
+        try
+        {
+            func();
+        }
+        catch (...)
+        {
+            state.setException(std::current_exception());
+            return;
+        }
+        state.setValue();
+    }
+    else
+    {
+        std::optional<T> result;
+        try
+        {
+            result.emplace(func());
+        }
+        catch (...)
+        {
+            state.setException(std::current_exception());
+            return;
+        }
+        state.setValue(std::move(*result));
+    }
+}
+
+// 跟随任务移动的结果写入权. 任务执行时通过 fulfil 写入结果; 任务未执行就析构 (被 DropOldest 丢弃, shutdownNow
+// 清空队列, 定时器停止) 时以 broken_promise 完成结果, 与 std::packaged_task 一致, 等待方不会永远阻塞
+template<typename T>
+class Completion
+{
+public:
+    explicit Completion(std::shared_ptr<TaskState<T>> state)
+        : state(std::move(state))
+    {
+    }
+
+    Completion(Completion&&) noexcept = default;
+    Completion& operator=(Completion&&) = delete;
+
+    ~Completion()
+    {
+        if (state)
+            state->setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+
+    template<typename F>
+    void fulfil(F&& func)
+    {
+        const auto target = std::move(state);
+        threadpool::detail::fulfil(*target, std::forward<F>(func));
+    }
+
+private:
+    std::shared_ptr<TaskState<T>> state;
+};
+
+struct TaskFutureAccess
+{
+    template<typename T>
+    static const std::shared_ptr<TaskState<T>>& state(const TaskFuture<T>& future)
+    {
+        return future.state;
+    }
+};
+
+// 所有状态都完成后, 在最后完成的线程上调用 done
+template<typename Done>
+void whenAllReady(const std::vector<std::shared_ptr<TaskStateBase>>& states, Done done)
+{
+    if (states.empty())
+    {
+        done();
+        return;
+    }
+
+    struct Join
+    {
+        Join(size_t count, Done done)
+            : remaining(count)
+            , done(std::move(done))
+        {
+        }
+
+        std::atomic<size_t> remaining;
+        Done done;
+    };
+    auto join = std::make_shared<Join>(states.size(), std::move(done));
+    for (const auto& state : states)
+    {
+        state->onReady(
+            [join]()
+            {
+                if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    join->done();
+            });
+    }
+}
+
+}  // namespace threadpool::detail
+
+// 可共享的异步结果, 类似 std::shared_future, 但可以挂接在线程池上执行的后续任务.
+// 在工作线程内调用 get()/wait() 时该线程会执行其它排队任务直到结果就绪, 不会死锁, 但可能因执行无关任务而晚于结果返回;
+// 多阶段流水线仍应使用 then()/whenAll() 串联.
+template<typename T>
+class TaskFuture
+{
+public:
+    TaskFuture() = default;
+
+    explicit TaskFuture(std::shared_ptr<threadpool::detail::TaskState<T>> state)
+        : state(std::move(state))
+    {
+    }
+
+    bool valid() const
+    {
+        return state != nullptr;
+    }
+
+    bool isReady() const
+    {
+        return state->isReady();
+    }
+
+    void wait() const
+    {
+        state->wait();
+    }
+
+    // T 不是 void 时返回结果的常量引用, 任务抛出的异常在此重新抛出
+    decltype(auto) get() const
+    {
+        state->wait();
+        if (state->exception())
+            std::rethrow_exception(state->exception());
+        if constexpr (!std::is_void_v<T>)
+            return (state->value());
+    }
+
+    // 本结果就绪后把 f 投递到同一线程池, f 接收 const T& (T 为 void 时无参数).
+    // 从工作线程完成时后续任务进入该线程的本地队列. 前驱抛出的异常直接传递给返回的结果, 不调用 f.
+    template<typename F>
+    auto then(F&& f) const
+    {
+        using result_type = typename decltype(invokeResult<F>())::type;
+
+        auto next = std::make_shared<threadpool::detail::TaskState<result_type>>(state->getPool());
+        state->onReady(
+            [antecedent = state, next, func = std::forward<F>(f)]() mutable
+            {
+                if (antecedent->exception())
+                {
+                    next->setException(antecedent->exception());
+                    return;
+                }
+                auto continuation =
+                    [antecedent, completion = threadpool::detail::Completion<result_type>(next),
+                     func = std::move(func)]() mutable
+                {
+                    completion.fulfil(
+                        [&]() -> result_type
+                        {
+                            if constexpr (std::is_void_v<T>)
+                                return func();
+                            else
+                                return func(antecedent->value());
+                        });
+                };
+
+                ThreadPool* pool = next->getPool();
+                if (pool == nullptr)
+                {
+                    continuation();
+                    return;
+                }
+                try
+                {
+                    pool->post(std::move(continuation));
+                }
+                catch (...)
+                {
+                    // 线程池已停止: 后续任务随异常析构, 由 Completion 以 broken_promise 完成结果
+                }
+            });
+        return TaskFuture<result_type>(std::move(next));
+    }
+
+private:
+    friend struct threadpool::detail::TaskFutureAccess;
+
+    template<typename F>
+    static auto invokeResult()
+    {
+        if constexpr (std::is_void_v<T>)
+            return std::type_identity<std::invoke_result_t<std::decay_t<F>&>>{};
+        else
+            return std::type_identity<std::invoke_result_t<std::decay_t<F>&, const T&>>{};
+    }
+
+    std::shared_ptr<threadpool::detail::TaskState<T>> state;
+};
+
+namespace threadpool::detail
+{
+
+template<typename T>
+std::vector<std::shared_ptr<TaskStateBase>> statesOf(const std::vector<TaskFuture<T>>& futures)
+{
+    std::vector<std::shared_ptr<TaskStateBase>> states;
+    states.reserve(futures.size());
+    for (const auto& future : futures)
+    {
+        states.push_back(TaskFutureAccess::state(future));
+    }
+    return states;
+}
+
+inline TaskFuture<size_t> whenAnyReady(const std::vector<std::shared_ptr<TaskStateBase>>& states)
+{
+    if (states.empty())
+        throw std::invalid_argument("whenAny requires at least one future");
+
+    struct Race
+    {
+        std::atomic<bool> done{false};
+        std::shared_ptr<TaskState<size_t>> result;
+    };
+    auto race = std::make_shared<Race>();
+    race->result = std::make_shared<TaskState<size_t>>(states.front()->getPool());
+    auto result = TaskFuture<size_t>(race->result);
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        states[i]->onReady(
+            [race, i]()
+            {
+                if (!race->done.exchange(true, std::memory_order_acq_rel))
+                    race->result->setValue(i);
+            });
+    }
+    return result;
+}
+
+}  // namespace threadpool::detail
+
+// 在线程池上执行 f(args...), 返回可挂接后续任务的 TaskFuture
+template<typename F, typename... Args>
+auto spawn(ThreadPool& pool, F&& f, Args&&... args) -> TaskFuture<std::invoke_result_t<F, Args...>>
+{
+    using return_type = std::invoke_result_t<F, Args...>;
+
+    auto state = std::make_shared<threadpool::detail::TaskState<return_type>>(&pool);
+    pool.post(
+        [completion = threadpool::detail::Completion<return_type>(state), func = std::forward<F>(f),
+         ... params = std::forward<Args>(args)]() mutable
+        {
+            completion.fulfil([&]() -> return_type { return std::invoke(std::move(func), std::move(params)...); });
+        });
+    return TaskFuture<return_type>(std::move(state));
+}
+
+// delay 之后在线程池上执行 f(args...), 等待期间不占用工作线程. 任务未执行就被丢弃时结果为 broken_promise
+template<typename Rep, typename Period, typename F, typename... Args>
+auto spawnAfter(ThreadPool& pool, std::chrono::duration<Rep, Period> delay, F&& f, Args&&... args)
+    -> TaskFuture<std::invoke_result_t<F, Args...>>
+{
+    using return_type = std::invoke_result_t<F, Args...>;
+
+    auto state = std::make_shared<threadpool::detail::TaskState<return_type>>(&pool);
+    pool.scheduleAfter(delay,
+                       [completion = threadpool::detail::Completion<return_type>(state), func = std::forward<F>(f),
+                        ... params = std::forward<Args>(args)]() mutable
+                       {
+                           completion.fulfil([&]() -> return_type
+                                             { return std::invoke(std::move(func), std::move(params)...); });
+                       });
+    return TaskFuture<return_type>(std::move(state));
+}
+
+// 所有输入都完成后就绪. T 不是 void 时结果为按输入顺序排列的值, 任一输入失败则传递第一个失败输入的异常
+template<typename T>
+auto whenAll(const std::vector<TaskFuture<T>>& futures)
+{
+    using result_type = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+    auto states = threadpool::detail::statesOf(futures);
+    auto result = std::make_shared<threadpool::detail::TaskState<result_type>>(
+        states.empty() ? nullptr : states.front()->getPool());
+    threadpool::detail::whenAllReady(states,
+                                     [result, states]()
+                                     {
+                                         for (const auto& state : states)
+                                         {
+                                             if (state->exception())
+                                             {
+                                                 result->setException(state->exception());
+                                                 return;
+                                             }
+                                         }
+                                         threadpool::detail::fulfil(
+                                             *result,
+                                             [&]() -> result_type
+                                             {
+                                                 if constexpr (!std::is_void_v<T>)
+                                                 {
+                                                     std::vector<T> values;
+                                                     values.reserve(states.size());
+                                                     for (const auto& state : states)
+                                                     {
+                                                         values.push_back(
+                                                             static_cast<threadpool::detail::TaskState<T>&>(*state)
+                                                                 .value());
+                                                     }
+                                                     return values;
+                                                 }
+                                             });
+                                     });
+    return TaskFuture<result_type>(std::move(result));
+}
+
+// 不同类型的输入全部完成后就绪, 只传递完成信号与第一个失败输入的异常
+template<typename... Ts>
+    requires(sizeof...(Ts) > 0)
+TaskFuture<void> whenAll(const TaskFuture<Ts>&... futures)
+{
+    std::vector<std::shared_ptr<threadpool::detail::TaskStateBase>> states{
+        threadpool::detail::TaskFutureAccess::state(futures)...};
+    auto result = std::make_shared<threadpool::detail::TaskState<void>>(states.front()->getPool());
+    threadpool::detail::whenAllReady(states,
+                                     [result, states]()
+                                     {
+                                         for (const auto& state : states)
+                                         {
+                                             if (state->exception())
+                                             {
+                                                 result->setException(state->exception());
+                                                 return;
+                                             }
+                                         }
+                                         result->setValue();
+                                     });
+    return TaskFuture<void>(std::move(result));
+}
+
+// 任一输入完成 (成功或失败) 后就绪, 结果为该输入的下标
+template<typename T>
+TaskFuture<size_t> whenAny(const std::vector<TaskFuture<T>>& futures)
+{
+    return threadpool::detail::whenAnyReady(threadpool::detail::statesOf(futures));
+}
+
+template<typename... Ts>
+    requires(sizeof...(Ts) > 0)
+TaskFuture<size_t> whenAny(const TaskFuture<Ts>&... futures)
+{
+    return threadpool::detail::whenAnyReady({threadpool::detail::TaskFutureAccess::state(futures)...});
+}
+
+// 显式构建的有向无环任务图. 每个节点记录前驱数量, 运行时前驱计数归零的后继直接交给完成前驱的工作线程:
+// 第一个就绪的后继在当前线程上接着执行, 其余后继投递到线程池 (工作窃取模式下进入本线程的本地队列).
+// 同一个图可以重复运行, 但不能并发运行; 图必须存活到 run() 返回的结果就绪.
+// 任一节点抛出异常后, 尚未开始的节点不再执行, 异常通过 run() 的结果传递. 节点任务被线程池丢弃或因线程池停止而
+// 无法投递时同样使图失败, run() 的结果得到 broken_promise.
+class TaskGraph
+{
+public:
+    using NodeId = size_t;
+
+    template<typename F>
+        requires std::is_invocable_v<std::decay_t<F>&>
+    NodeId add(F&& work)
+    {
+        nodes.push_back(std::make_unique<Node>(UniqueTask(std::forward<F>(work))));
+        validated = false;
+        return nodes.size() - 1;
+    }
+
+    // before 完成后才能执行 after
+    void precede(NodeId before, NodeId after)
+    {
+        if (before >= nodes.size() || after >= nodes.size())
+            throw std::out_of_range("TaskGraph node id out of range");
+        nodes[before]->successors.push_back(after);
+        nodes[after]->dependencies++;
+        validated = false;
+    }
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+
+    TaskFuture<void> run(ThreadPool& pool)
+    {
+        if (running.exchange(true))
+            throw std::logic_error("TaskGraph is already running");
+
+        auto state = std::make_shared<threadpool::detail::TaskState<void>>(&pool);
+        if (nodes.empty())
+        {
+            running = false;
+            state->setValue();
+            return TaskFuture<void>(std::move(state));
+        }
+        if (!validated && !(validated = isAcyclic()))
+        {
+            running = false;
+            throw std::logic_error("TaskGraph contains a cycle");
+        }
+
+        for (auto& node : nodes)
+        {
+            node->pending.store(node->dependencies, std::memory_order_relaxed);
+        }
+        remaining.store(nodes.size(), std::memory_order_relaxed);
+        failed.store(false, std::memory_order_relaxed);
+        error = nullptr;
+        completion = state;
+        this->pool = &pool;
+
+        // 先收集根节点再投递, 避免投递过程中节点完成并修改计数
+        std::vector<NodeId> roots;
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            if (nodes[id]->dependencies == 0)
+                roots.push_back(id);
+        }
+        for (NodeId id : roots)
+        {
+            spawnNode(id);
+        }
+        return TaskFuture<void>(std::move(state));
+    }
+
+private:
+    static constexpr NodeId NoNode = static_cast<NodeId>(-1);
+
+    struct Node
+    {
+        explicit Node(UniqueTask work)
+            : work(std::move(work))
+        {
+        }
+
+        UniqueTask work;
+        std::vector<NodeId> successors;
+        size_t dependencies = 0;
+        std::atomic<size_t> pending{0};
+    };
+
+    // Kahn 拓扑排序, 能排完所有节点即无环
+    bool isAcyclic() const
+    {
+        std::vector<size_t> inDegree(nodes.size());
+        std::vector<NodeId> ready;
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            inDegree[id] = nodes[id]->dependencies;
+            if (inDegree[id] == 0)
+                ready.push_back(id);
+        }
+        size_t visited = 0;
+        while (!ready.empty())
+        {
+            NodeId id = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (NodeId successor : nodes[id]->successors)
+            {
+                if (--inDegree[successor] == 0)
+                    ready.push_back(successor);
+            }
+        }
+        return visited == nodes.size();
+    }
+
+    // 跟随节点任务移动, 任务未执行就析构 (线程池丢弃或拒绝) 时放弃该节点, 保证 run() 的结果最终就绪
+    class NodeTicket
+    {
+    public:
+        NodeTicket(TaskGraph* graph, NodeId id)
+            : graph(graph)
+            , id(id)
+        {
+        }
+
+        NodeTicket(NodeTicket&& other) noexcept
+            : graph(std::exchange(other.graph, nullptr))
+            , id(other.id)
+        {
+        }
+
+        NodeTicket& operator=(NodeTicket&&) = delete;
+
+        ~NodeTicket()
+        {
+            if (graph)
+                graph->abandon(id);
+        }
+
+        void run()
+        {
+            std::exchange(graph, nullptr)->execute(id);
+        }
+
+    private:
+        TaskGraph* graph;
+        NodeId id;
+    };
+
+    void spawnNode(NodeId id)
+    {
+        try
+        {
+            pool->post([ticket = NodeTicket(this, id)]() mutable { ticket.run(); });
+        }
+        catch (const std::exception&)
+        {
+            // 线程池已停止或拒绝: 节点任务已随异常析构, 由 NodeTicket 放弃该节点
+        }
+    }
+
+    void recordError(std::exception_ptr exception)
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = std::move(exception);
+        failed = true;
+    }
+
+    // 节点未执行就被丢弃: 图以 broken_promise 失败, 在当前线程跳过该节点及由此就绪的后继, 不再向线程池投递
+    void abandon(NodeId id)
+    {
+        recordError(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        std::vector<NodeId> skipped{id};
+        while (!skipped.empty())
+        {
+            const NodeId current = skipped.back();
+            skipped.pop_back();
+            for (NodeId successor : nodes[current]->successors)
+            {
+                if (nodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    skipped.push_back(successor);
+            }
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                finish();
+                return;
+            }
+        }
+    }
+
+    void execute(NodeId id)
+    {
+        while (id != NoNode)
+        {
+            Node& node = *nodes[id];
+            if (!failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    node.work();
+                }
+                catch (...)
+                {
+                    recordError(std::current_exception());
+                }
+            }
+
+            NodeId next = NoNode;
+            for (NodeId successor : node.successors)
+            {
+                if (nodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    if (next == NoNode)
+                        next = successor;
+                    else
+                        spawnNode(successor);
+                }
+            }
+
+            // 最后一个节点没有就绪的后继, 完成后不再访问图
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                finish();
+                return;
+            }
+            id = next;
+        }
+    }
+
+    void finish()
+    {
+        auto state = std::move(completion);
+        std::exception_ptr exception = std::exchange(error, nullptr);
+        running = false;
+        if (exception)
+            state->setException(std::move(exception));
+        else
+            state->setValue();
+    }
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    bool validated = false;
+
+    // 单次运行的状态
+    ThreadPool* pool = nullptr;
+    std::atomic<bool> running{false};
+    std::atomic<size_t> remaining{0};
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::shared_ptr<threadpool::detail::TaskState<void>> completion;
+};
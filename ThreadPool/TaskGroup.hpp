@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+// 可整体取消的一组任务. cancel() 之后尚未开始的任务被跳过 (其 future 得到 broken_promise),
+// 正在执行的任务可以通过 std::stop_token 参数观察取消请求: 第一个参数为 std::stop_token 的任务会收到组的停止令牌.
+// 线程池 shutdownNow 或关闭超时也会取消所有任务组. 析构时取消并等待组内任务结束.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool)
+        : pool(pool)
+        , poolStopped(pool.getStopToken(), [this]() { cancel(); })
+    {
+    }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup()
+    {
+        cancel();
+        wait();
+    }
+
+    template<typename F, typename... Args>
+    auto enqueue(F&& f, Args&&... args)
+    {
+        using return_type = decltype(invokeWith(std::declval<std::stop_token>(), std::declval<std::decay_t<F>>(),
+                                                std::declval<std::decay_t<Args>>()...));
+
+        std::packaged_task<return_type(std::stop_token)> task(
+            [func = std::forward<F>(f), ... params = std::forward<Args>(args)](std::stop_token token) mutable
+            { return invokeWith(std::move(token), std::move(func), std::move(params)...); });
+        std::future<return_type> res = task.get_future();
+        submit(std::move(task));
+        return res;
+    }
+
+    template<typename F, typename... Args>
+    void post(F&& f, Args&&... args)
+    {
+        submit([func = std::forward<F>(f), ... params = std::forward<Args>(args)](std::stop_token token) mutable
+               { invokeWith(std::move(token), std::move(func), std::move(params)...); });
+    }
+
+    void cancel()
+    {
+        stopSource.request_stop();
+    }
+
+    bool isCancelled() const
+    {
+        return stopSource.stop_requested();
+    }
+
+    std::stop_token getStopToken() const
+    {
+        return stopSource.get_token();
+    }
+
+    // 等待组内已提交的任务执行完或被跳过. 在同一线程池的工作线程上等待时协助执行排队任务, 任务中可以创建子组并等待
+    void wait()
+    {
+        pool.helpUntil([this] { return outstanding.load() == 0; });
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return outstanding.load() == 0; });
+    }
+
+    template<typename Rep, typename Period>
+    bool waitFor(std::chrono::duration<Rep, Period> timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return finished.wait_for(lock, timeout, [this] { return outstanding.load() == 0; });
+    }
+
+    // 因取消而未执行的任务数
+    size_t getCancelledTasks() const
+    {
+        return cancelledTasks;
+    }
+
+private:
+    template<typename F, typename... Args>
+    static decltype(auto) invokeWith(std::stop_token token, F&& f, Args&&... args)
+    {
+        if constexpr (std::is_invocable_v<F, std::stop_token, Args...>)
+            return std::invoke(std::forward<F>(f), std::move(token), std::forward<Args>(args)...);
+        else
+            return std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 跟随任务移动, 任务执行完, 被跳过或被线程池丢弃而析构时都会归还计数.
+    // 闭包只捕获 Ticket 和任务本身, 包装一个 std::function 时仍能放进 UniqueTask 的内联缓冲区
+    class Ticket
+    {
+    public:
+        explicit Ticket(TaskGroup* group)
+            : group(group)
+        {
+            group->outstanding++;
+        }
+
+        Ticket(Ticket&& other) noexcept
+            : group(std::exchange(other.group, nullptr))
+        {
+        }
+
+        Ticket& operator=(Ticket&&) = delete;
+
+        ~Ticket()
+        {
+            if (group == nullptr)
+                return;
+            // 不是最后一个任务时无锁递减; 最后一个任务在锁内归零并通知, 等待方看到归零时本对象已不再访问任务组
+            size_t count = group->outstanding.load();
+            while (count > 1)
+            {
+                if (group->outstanding.compare_exchange_weak(count, count - 1))
+                    return;
+            }
+            ThreadPool& pool = group->pool;
+            {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                if (--group->outstanding == 0)
+                    group->finished.notify_all();
+            }
+            pool.notifyHelpers();
+        }
+
+        template<typename Task>
+        void run(Task& task) const
+        {
+            if (group->isCancelled())
+            {
+                group->cancelledTasks++;
+                return;
+            }
+            task(group->getStopToken());
+        }
+
+    private:
+        TaskGroup* group;
+    };
+
+    template<typename Task>
+    void submit(Task task)
+    {
+        pool.post([ticket = Ticket(this), task = std::move(task)]() mutable { ticket.run(task); });
+    }
+
+    ThreadPool& pool;
+    std::stop_source stopSource;
+    mutable std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<size_t> outstanding{0};
+    std::atomic<size_t> cancelledTasks{0};
+    std::stop_callback<std::function<void()>> poolStopped;
+};
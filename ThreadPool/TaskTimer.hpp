@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class TimingMode
+{
+    SteadyClock,  // 使用 std::chrono::steady_clock, 每次读取是一次 vDSO 调用, 约 20ns
+    Tsc,          // 直接读取 CPU 时间戳计数器 (x86 rdtsc / ARM cntvct), 约几 ns, 启动时与 steady_clock 校准一次
+    Off,          // 不计时, 延迟统计为空, 弹性伸缩只依据排队任务数
+};
+
+// 任务排队与执行耗时的统计方式. sampleInterval 为 N 时每 N 个任务统计一个, 其余任务不读取时钟
+struct TimingOptions
+{
+    TimingMode mode = TimingMode::SteadyClock;
+    uint32_t sampleInterval = 1;
+};
+
+// CPU 时间戳计数器, 假定计数频率恒定 (现代 x86 的 invariant TSC, ARM 的通用定时器); 不支持的平台退化为 steady_clock
+class TscClock
+{
+public:
+    static uint64_t now() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#endif
+    }
+
+    // 每个计数对应的纳秒数, 首次调用时校准
+    static double nanosecondsPerTick()
+    {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate()
+    {
+#if defined(__aarch64__)
+        uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        return frequency > 0 ? 1e9 / static_cast<double>(frequency) : 1.0;
+#elif defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        // 忙等约 2ms 对比两个时钟, 误差在千分之一量级
+        const auto startTime = std::chrono::steady_clock::now();
+        const uint64_t startTicks = now();
+        auto endTime = startTime;
+        while (endTime - startTime < std::chrono::milliseconds(2))
+        {
+            endTime = std::chrono::steady_clock::now();
+        }
+        const uint64_t endTicks = now();
+        const double nanoseconds = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+        return endTicks > startTicks ? nanoseconds / static_cast<double>(endTicks - startTicks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+// 按 TimingOptions 读取时间戳. 返回 0 表示该任务不参与统计.
+// 采样计数属于计时器本身, 按提交方分片 (通常每个工作线程一个, 池外线程共用最后一个), 不同线程池互不影响
+class TaskTimer
+{
+public:
+    explicit TaskTimer(const TimingOptions& options, size_t shardCount = 1)
+        : mode(options.mode)
+        , sampleInterval(std::max<uint32_t>(1, options.sampleInterval))
+        , nanosecondsPerTick(options.mode == TimingMode::Tsc ? TscClock::nanosecondsPerTick() : 1.0)
+        , shardCount(std::max<size_t>(1, shardCount))
+        , counters(std::make_unique<SampleCounter[]>(this->shardCount))
+    {
+    }
+
+    bool enabled() const noexcept
+    {
+        return mode != TimingMode::Off;
+    }
+
+    // 提交时调用: 按采样间隔决定当前任务是否参与统计, shard 超出范围时使用最后一个分片
+    bool shouldSample(size_t shard) const noexcept
+    {
+        if (mode == TimingMode::Off)
+            return false;
+        if (sampleInterval > 1)
+        {
+            std::atomic<uint32_t>& submitted = counters[std::min(shard, shardCount - 1)].submitted;
+            if ((submitted.fetch_add(1, std::memory_order_relaxed) + 1) % sampleInterval != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // 需要统计时返回入队时间戳, 否则返回 0, 不读取时钟
+    uint64_t sample(size_t shard) const noexcept
+    {
+        return shouldSample(shard) ? now() : 0;
+    }
+
+    uint64_t now() const noexcept
+    {
+        // 保证非 0, 0 留给未采样的任务
+        if (mode == TimingMode::Tsc)
+            return std::max<uint64_t>(1, TscClock::now());
+        return std::max<uint64_t>(1, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                               std::chrono::steady_clock::now().time_since_epoch())
+                                                               .count()));
+    }
+
+    uint64_t toNanoseconds(uint64_t start, uint64_t end) const noexcept
+    {
+        if (end <= start)
+            return 0;
+        if (mode == TimingMode::Tsc)
+            return static_cast<uint64_t>(static_cast<double>(end - start) * nanosecondsPerTick);
+        return end - start;
+    }
+
+private:
+    struct alignas(64) SampleCounter
+    {
+        std::atomic<uint32_t> submitted{0};
+    };
+
+    const TimingMode mode;
+    const uint32_t sampleInterval;
+    const double nanosecondsPerTick;
+    const size_t shardCount;
+    const std::unique_ptr<SampleCounter[]> counters;
+};
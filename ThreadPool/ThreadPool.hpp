@@ -1,95 +1,420 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <ranges>
+#include <stdexcept>
+#include <stop_token>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
+#include "Affinity.hpp"
+#include "LatencyHistogram.hpp"
+#include "OverflowPolicy.hpp"
+#include "PriorityLanes.hpp"
+#include "RingDeque.hpp"
+#include "ScalingPolicy.hpp"
+#include "ShardedCounter.hpp"
+#include "StrandQueue.hpp"
+#include "TaskTimer.hpp"
+#include "TimerWheel.hpp"
+#include "UniqueTask.hpp"
+#include "WaitStrategy.hpp"
+#include "WorkStealingQueue.hpp"
+
+enum class SchedulingMode
+{
+    SharedQueue,   // 所有工作线程共享一个任务队列
+    WorkStealing,  // 每个工作线程持有本地双端队列, 空闲时从其它线程窃取
+};
+
+struct ThreadPoolOptions
+{
+    static constexpr std::chrono::milliseconds DefaultAgingThreshold{100};
+
+    ThreadPoolOptions() = default;
+
+    // 只指定调度模式 (与老化阈值) 的简写, 其余字段取默认值
+    explicit ThreadPoolOptions(SchedulingMode mode, std::chrono::milliseconds agingThreshold = DefaultAgingThreshold)
+        : mode(mode)
+        , agingThreshold(agingThreshold)
+    {
+    }
+
+    SchedulingMode mode = SchedulingMode::SharedQueue;
+    // 低优先级任务等待超过该时长后排到普通任务之前
+    std::chrono::milliseconds agingThreshold = DefaultAgingThreshold;
+
+    // maxThreads 大于 0 时启用弹性模式, 线程数在 [minThreads, maxThreads] 之间伸缩
+    size_t minThreads = 0;
+    size_t maxThreads = 0;
+    std::chrono::milliseconds idleTimeout{5000};
+    std::shared_ptr<IScalingPolicy> scalingPolicy;  // 为空时使用 ThresholdScalingPolicy
+
+    // 工作线程的 CPU 绑定方式, 按槽位计算, 弹性模式下新建的线程绑定到其槽位对应的 CPU
+    AffinityOptions affinity;
+
+    // 空闲工作线程的等待方式, 默认立即休眠
+    WaitStrategy waitStrategy;
+
+    // 排队任务数上限, 0 表示不限制. 并发提交时是近似上限, 最多超出同时提交的线程数
+    size_t capacity = 0;
+    OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+
+    // 排队与执行耗时的计时方式与采样间隔, 影响 getLatencyStats 与按排队时间扩容的弹性策略
+    TimingOptions timing;
+};
+
 class ThreadPool
 {
 public:
-    explicit ThreadPool(size_t numThreads)
-        : stop(false)
-        , idleThreads(numThreads)
+    explicit ThreadPool(size_t numThreads, const ThreadPoolOptions& options = {})
+        : mode(options.mode)
+        , elastic(options.maxThreads > 0)
+        , minThreads(elastic ? std::min(options.minThreads, numThreads) : numThreads)
+        , maxThreads(elastic ? std::max(options.maxThreads, numThreads) : numThreads)
+        , idleTimeout(options.idleTimeout)
+        , scalingPolicy(options.scalingPolicy ? options.scalingPolicy : std::make_shared<ThresholdScalingPolicy>())
+        , affinity(options.affinity, maxThreads)
+        , waitStrategy(options.waitStrategy)
+        , capacity(options.capacity)
+        , overflowPolicy(options.overflowPolicy)
+        , timer(options.timing, maxThreads + 1)
+        , stop(false)
+        , idleThreads(0)
         , activeThreads(0)
-        , totalTasks(0)
+        , totalTasks(maxThreads + 1)
+        , pendingTasks(maxThreads + 1)
+        , sleepingThreads(0)
+        , nextQueue(0)
+        , liveThreads(0)
+        , workers(maxThreads)
+        , workerAlive(maxThreads, false)
+        , workerStats(maxThreads + 1)
+        , priorityLanes(options.agingThreshold)
     {
+        if (mode == SchedulingMode::WorkStealing)
+        {
+            localQueues = std::vector<WorkStealingQueue<TaskType>>(maxThreads);
+            buildStealOrder();
+        }
         for (size_t i = 0; i < numThreads; ++i)
         {
-            workers.emplace_back(
-                [this]()
-                {
-                    while (true)
-                    {
-                        std::function<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(queue_mutex);
-                            condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                            if (stop && tasks.empty())
-                                return;
-                            task = std::move(tasks.front());
-                            tasks.pop();
-                        }
-                        idleThreads--;
-                        activeThreads++;
-                        task();
-                        activeThreads--;
-                        idleThreads++;
-                        if (stop && tasks.empty())
-                            return;
-                    }
-                });
+            startWorker(i);
         }
     }
 
     template<typename F, typename... Args>
     auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
     {
-        using return_type = std::invoke_result_t<F, Args...>;
+        return enqueue(TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template<typename F, typename... Args>
+    auto enqueue(TaskPriority priority, F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        auto [task, res] = package(std::forward<F>(f), std::forward<Args>(args)...);
+        pushTask(UniqueTask(std::move(task)), priority);
+        return std::move(res);
+    }
+
+    // 截止时间任务进入高优先级通道, 按截止时间最早优先执行
+    template<typename F, typename... Args>
+    auto enqueue(std::chrono::steady_clock::time_point deadline, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        auto [task, res] = package(std::forward<F>(f), std::forward<Args>(args)...);
+        pushUrgentTask(UniqueTask(std::move(task)), deadline);
+        return std::move(res);
+    }
 
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    // 提交不需要返回值的任务, 不创建 future, 小闭包不产生任何堆分配
+    template<typename F, typename... Args>
+        requires std::is_invocable_v<F, Args...>
+    void post(F&& f, Args&&... args)
+    {
+        post(TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
 
-        std::future<return_type> res = task->get_future();
+    template<typename F, typename... Args>
+    void post(TaskPriority priority, F&& f, Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 0)
         {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop)
-                throw std::runtime_error("enqueue on stopped ThreadPool");
-            tasks.emplace(
-                [this, task]()
-                {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    (*task)();
-                    auto end = std::chrono::high_resolution_clock::now();
-                    std::chrono::duration<double, std::milli> elapsed = end - start;
-                    updateStats(elapsed.count());
-                });
+            pushTask(UniqueTask(std::forward<F>(f)), priority);
+        }
+        else
+        {
+            pushTask(UniqueTask([func = std::forward<F>(f), ... params = std::forward<Args>(args)]() mutable
+                                { std::invoke(std::move(func), std::move(params)...); }),
+                     priority);
         }
-        totalTasks++;
-        condition.notify_one();
-        return res;
     }
 
-    ~ThreadPool()
+    // 同一个 key 的任务按提交顺序串行执行, 不同 key 的任务并行执行. key 散列到固定数量的串行队列, 散列冲突的 key
+    // 之间也会串行, 但不影响顺序保证. 工作窃取模式下同一串行队列的任务优先交给同一个工作线程, 保持缓存局部性.
+    // 有界模式下串行队列中积压的任务计入容量, 队列已满时按溢出策略处理新提交的任务 (Reject 抛出 QueueFullError);
+    // 已接受的任务不会被 DropOldest 丢弃, shutdownNow 丢弃其中排队的任务并计入返回值
+    template<typename Key, typename F, typename... Args>
+    auto enqueueKeyed(const Key& key, F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        auto [task, res] = package(std::forward<F>(f), std::forward<Args>(args)...);
+        pushKeyed(strandSlot(std::hash<Key>{}(key)), UniqueTask(std::move(task)));
+        return std::move(res);
+    }
+
+    template<typename Key, typename F, typename... Args>
+    void postKeyed(const Key& key, F&& f, Args&&... args)
     {
+        const size_t slot = strandSlot(std::hash<Key>{}(key));
+        if constexpr (sizeof...(Args) == 0)
         {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
+            pushKeyed(slot, UniqueTask(std::forward<F>(f)));
+        }
+        else
+        {
+            pushKeyed(slot, UniqueTask([func = std::forward<F>(f), ... params = std::forward<Args>(args)]() mutable
+                                       { std::invoke(std::move(func), std::move(params)...); }));
+        }
+    }
+
+    // 等待 future 就绪. 在本线程池的工作线程上调用时, 等待期间执行队列中的其它任务而不是阻塞, 嵌套的 fork/join
+    // 不会因为工作线程都阻塞在等待上而死锁, 也不会空占线程. 在其它线程上调用时直接阻塞等待
+    template<typename Future>
+    void wait(const Future& future)
+    {
+        helpUntil([&future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+        future.wait();
+    }
+
+    // 在本线程池的工作线程上执行排队任务, 直到 ready() 为 true. 队列为空时说明依赖的任务正在其它线程上执行,
+    // 先让出 CPU 若干次, 之后与空闲的工作线程一样在 condition 上休眠, 由新任务或 notifyHelpers 唤醒.
+    // 等待目标可能在线程池之外完成 (其它线程设置的 promise, 其它线程池), 因此休眠有上限, 超时后重新检查,
+    // 上限从 HelpParkMin 倍增到 HelpParkMax. 休眠期间计为空闲线程. 调用线程不是本线程池的工作线程时立即返回 false
+    template<typename Predicate>
+    bool helpUntil(Predicate&& ready)
+    {
+        const WorkerContext& context = currentWorker();
+        if (context.pool != this)
+            return false;
+        const size_t index = context.index;
+        size_t idleRounds = 0;
+        auto park = HelpParkMin;
+        while (!ready())
+        {
+            TaskType task;
+            if (tryPopTask(index, task))
+            {
+                runTask(task, index);
+                idleRounds = 0;
+                park = HelpParkMin;
+                continue;
+            }
+            if (++idleRounds < HelpSpinRounds)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            activeThreads--;
+            idleThreads++;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                sleepingThreads++;
+                helpingThreads++;
+                condition.wait_for(lock, park, [&] { return queuedTasks() > 0 || ready(); });
+                helpingThreads--;
+                sleepingThreads--;
+            }
+            idleThreads--;
+            activeThreads++;
+            idleRounds = 0;
+            park = std::min(park * 2, HelpParkMax);
+        }
+        return true;
+    }
+
+    // 唤醒在 helpUntil 中休眠的线程重新检查等待条件. 任务执行完或被丢弃时线程池自动调用,
+    // 在线程池之外完成等待目标 (如 TaskFuture 的结果) 时由完成方调用. 没有休眠的协助线程时只有一次原子读;
+    // 与休眠方的计数错过时由休眠上限兜底
+    void notifyHelpers()
+    {
+        if (helpingThreads.load(std::memory_order_acquire) == 0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
         }
         condition.notify_all();
-        for (std::thread& worker : workers)
+    }
+
+    // 定时任务: 到期后作为普通任务提交到线程池, 不占用工作线程等待. 定时器由一个专用线程以 1ms 刻度的分层时间轮管理,
+    // 首次使用时启动. 到期任务入队时不受容量限制, 队列已满也不会阻塞定时器线程或在其上执行.
+    // 线程池停止时尚未到期的定时任务被析构而不执行
+    template<typename Rep, typename Period, typename F, typename... Args>
+    TimerId scheduleAfter(std::chrono::duration<Rep, Period> delay, F&& f, Args&&... args)
+    {
+        return scheduleAt(std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+                          std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template<typename F, typename... Args>
+    TimerId scheduleAt(std::chrono::steady_clock::time_point time, F&& f, Args&&... args)
+    {
+        return addTimer(time, Clock::duration::zero(), bindTask(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    // 周期任务: 首次在 period 之后执行, 之后每隔 period 执行一次, 直到 cancelTimer.
+    // 上一次尚未执行完时跳过本次, 同一周期任务不会并发执行
+    template<typename Rep, typename Period, typename F, typename... Args>
+    TimerId scheduleEvery(std::chrono::duration<Rep, Period> period, F&& f, Args&&... args)
+    {
+        const auto interval = std::chrono::duration_cast<Clock::duration>(period);
+        if (interval <= Clock::duration::zero())
+            throw std::invalid_argument("scheduleEvery requires a positive period");
+        return addTimer(Clock::now() + interval, interval,
+                        bindTask(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    // 取消尚未触发的定时任务. 已经提交到线程池的任务不受影响, 返回 false 表示定时器已触发或已取消
+    bool cancelTimer(TimerId id)
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        return timerWheel.cancel(id);
+    }
+
+    size_t getPendingTimers() const
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        return timerWheel.size();
+    }
+
+    // 批量提交: 对 range 中每个元素调用一次 f, 整批任务只加一次锁, 并按任务数一次性唤醒工作线程
+    template<std::ranges::input_range Range, typename F>
+    auto enqueueBulk(Range&& range, F f)
+        -> std::vector<std::future<std::invoke_result_t<F&, std::ranges::range_reference_t<Range>>>>
+    {
+        using return_type = std::invoke_result_t<F&, std::ranges::range_reference_t<Range>>;
+        using value_type = std::ranges::range_value_t<Range>;
+
+        std::vector<std::future<return_type>> results;
+        std::vector<TaskType> batch;
+        if constexpr (std::ranges::sized_range<Range>)
+        {
+            results.reserve(std::ranges::size(range));
+            batch.reserve(std::ranges::size(range));
+        }
+
+        for (auto&& item : range)
+        {
+            std::packaged_task<return_type()> task(
+                [f, value = value_type(std::forward<decltype(item)>(item))]() mutable { return f(value); });
+            results.emplace_back(task.get_future());
+            batch.push_back(TaskType{UniqueTask(std::move(task)), Clock::time_point{}, 0, false});
+        }
+
+        pushTasks(std::move(batch));
+        return results;
+    }
+
+    // co_await pool.schedule() 挂起当前协程, 随后在工作线程上恢复执行
+    struct ScheduleAwaiter
+    {
+        ThreadPool& pool;
+        TaskPriority priority;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            pool.post(priority, [handle]() { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    ScheduleAwaiter schedule(TaskPriority priority = TaskPriority::Normal)
+    {
+        return ScheduleAwaiter{*this, priority};
+    }
+
+    // 析构时执行完所有已排队的任务
+    ~ThreadPool()
+    {
+        stopAccepting();
+        joinWorkers();
+    }
+
+    // 停止接收新任务并丢弃所有排队中的任务, 通过停止令牌请求正在执行的任务尽快结束, 等待工作线程退出.
+    // 被丢弃任务的 future 得到 broken_promise, 返回丢弃的任务数
+    size_t shutdownNow()
+    {
+        stopAccepting();
+        // 先发出停止请求, 被清空的串行队列调度任务据此丢弃而不是执行队列中的任务
+        stopSource.request_stop();
+        const size_t keyedBefore = discardedKeyedTasks.load();
+        std::vector<TaskType> victims = takeOldest(std::numeric_limits<size_t>::max(), true);
+        const auto discarded =
+            static_cast<size_t>(std::ranges::count_if(victims, [](const TaskType& task) { return !task.pinned; }));
+        // 串行队列的调度任务在这里析构, 其中排队的任务由 abandonStrand 丢弃并计数
+        victims.clear();
+        notifyHelpers();
+        joinWorkers();
+        return discarded + (discardedKeyedTasks.load() - keyedBefore);
+    }
+
+    // 有时限的优雅关闭: 停止接收新任务, 在 timeout 内继续执行排队中的任务, 超时后按 shutdownNow 丢弃剩余任务.
+    // 正在执行的任务不会被打断, 只会收到停止请求. 返回丢弃的任务数, 全部执行完时为 0
+    template<typename Rep, typename Period>
+    size_t shutdown(std::chrono::duration<Rep, Period> timeout)
+    {
+        stopAccepting();
+        const auto deadline = Clock::now() + timeout;
         {
-            worker.join();
+            std::unique_lock<std::mutex> lock(spaceMutex);
+            spaceWaiters++;
+            spaceCondition.wait_until(lock, deadline, [this] { return queuedTasks() == 0; });
+            spaceWaiters--;
         }
+        if (queuedTasks() == 0)
+        {
+            joinWorkers();
+            return 0;
+        }
+        return shutdownNow();
     }
 
+    // shutdownNow 或关闭超时后触发的停止令牌, 长时间运行的任务可以据此提前返回
+    std::stop_token getStopToken() const
+    {
+        return stopSource.get_token();
+    }
+
+    SchedulingMode getSchedulingMode() const
+    {
+        return mode;
+    }
+    size_t getThreadCount() const
+    {
+        return liveThreads;
+    }
+    bool isElastic() const
+    {
+        return elastic;
+    }
     size_t getIdleThreads() const
     {
         return idleThreads;
@@ -98,53 +423,1150 @@ public:
     {
         return activeThreads;
     }
+    // 无界模式下排队计数按线程分片, 有并发提交时返回近似值
     size_t getQueueSize() const
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        return tasks.size();
+        return queuedTasks();
     }
     size_t getTotalTasks() const
     {
-        return totalTasks;
+        return totalTasks.load();
+    }
+    size_t getCapacity() const
+    {
+        return capacity;
+    }
+    // 队列已满时被拒绝的任务数 (OverflowPolicy::Reject)
+    size_t getRejectedTasks() const
+    {
+        return rejectedTasks;
+    }
+    // 队列已满时被丢弃的已排队任务数 (OverflowPolicy::DropOldest)
+    size_t getDroppedTasks() const
+    {
+        return droppedTasks;
+    }
+
+    // 排队等待时间与执行时间的分布, 读取时合并各工作线程的分片
+    struct LatencyStats
+    {
+        LatencySummary queueWait;
+        LatencySummary execution;
+    };
+
+    LatencyStats getLatencyStats() const
+    {
+        HistogramSnapshot queueWait;
+        HistogramSnapshot execution;
+        for (const auto& shard : workerStats)
+        {
+            queueWait.merge(shard.queueWait);
+            execution.merge(shard.execution);
+        }
+        return LatencyStats{queueWait.summary(), execution.summary()};
     }
 
+    // 执行时间统计, 单位毫秒
     void getStats(double& avgTime, double& minTime, double& maxTime) const
     {
-        std::unique_lock<std::mutex> lock(stats_mutex);
-        avgTime = totalTaskTime / (totalTasks - tasks.size());
-        minTime = minTaskTime;
-        maxTime = maxTaskTime;
+        const LatencySummary execution = getLatencyStats().execution;
+        avgTime = execution.mean / 1e6;
+        minTime = static_cast<double>(execution.min) / 1e6;
+        maxTime = static_cast<double>(execution.max) / 1e6;
     }
 
     void resetStats()
     {
-        std::unique_lock<std::mutex> lock(stats_mutex);
-        totalTaskTime = 0;
-        minTaskTime = std::numeric_limits<double>::max();
-        maxTaskTime = 0;
+        for (auto& shard : workerStats)
+        {
+            shard.queueWait.reset();
+            shard.execution.reset();
+        }
     }
 
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    using Clock = std::chrono::steady_clock;
+
+    // enqueueTime 只用于低优先级任务的老化; enqueueStamp 是计时器的入队时间戳, 为 0 表示该任务不参与统计;
+    // pinned 的任务 (串行队列的调度任务) 入队时不经过容量许可, 也不会被 DropOldest 丢弃
+    struct QueuedTask
+    {
+        UniqueTask func;
+        Clock::time_point enqueueTime;
+        uint64_t enqueueStamp = 0;
+        bool pinned = false;
+    };
+    using TaskType = QueuedTask;
+
+    // 每个工作线程独占一个统计分片, 最后一个分片留给在池外线程上执行的任务
+    struct alignas(64) WorkerStats
+    {
+        LatencyHistogram queueWait;
+        LatencyHistogram execution;
+        std::atomic<uint64_t> lastQueueWait{0};
+    };
+
+    // 当前线程所属的线程池及工作线程下标, 用于把工作线程内提交的任务放入本地队列
+    struct WorkerContext
+    {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerContext& currentWorker()
+    {
+        static thread_local WorkerContext context;
+        return context;
+    }
+
+    // 提交线程对应的统计与采样分片: 本线程池的工作线程用各自的分片, 其它线程共用最后一个
+    size_t submitterShard() const
+    {
+        const WorkerContext& context = currentWorker();
+        return context.pool == this ? context.index : maxThreads;
+    }
+
+    // packaged_task 只持有一个共享状态指针, 可直接内联存放在 UniqueTask 中
+    template<typename F, typename... Args>
+    static auto package(F&& f, Args&&... args)
+    {
+        using return_type = std::invoke_result_t<F, Args...>;
+
+        std::packaged_task<return_type()> task(
+            [func = std::forward<F>(f), ... params = std::forward<Args>(args)]() mutable -> return_type
+            { return std::invoke(std::move(func), std::move(params)...); });
+        std::future<return_type> res = task.get_future();
+        return std::make_pair(std::move(task), std::move(res));
+    }
+
+    static constexpr size_t NoPreferredQueue = std::numeric_limits<size_t>::max();
+
+    // preferredQueue 只在工作窃取模式下生效, 指定任务放入哪个工作线程的本地队列
+    void pushTask(UniqueTask func, TaskPriority priority = TaskPriority::Normal,
+                  size_t preferredQueue = NoPreferredQueue)
+    {
+        if (priority == TaskPriority::High)
+        {
+            pushUrgentTask(std::move(func), Clock::now());
+            return;
+        }
+
+        if (stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        if (!admit(func))
+            return;
+        publishTask(std::move(func), priority, preferredQueue, false);
+    }
+
+    // 把已获准入队的任务放入对应队列, 不再检查容量
+    void publishTask(UniqueTask func, TaskPriority priority, size_t preferredQueue, bool pinned)
+    {
+        const size_t shard = submitterShard();
+        TaskType task{std::move(func), Clock::time_point{}, timer.sample(shard), pinned};
+
+        if (priority == TaskPriority::Low)
+        {
+            task.enqueueTime = Clock::now();
+            // 先计数再发布, 否则工作线程可能先取走任务并减计数, 使计数短暂下溢
+            countQueued(shard);
+            priorityLanes.pushLow(std::move(task));
+            totalTasks.add(shard);
+            wakeSleepingWorker();
+            return;
+        }
+
+        if (mode == SchedulingMode::SharedQueue)
+        {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                if (stop)
+                    throw std::runtime_error("enqueue on stopped ThreadPool");
+                tasks.push_back(std::move(task));
+                countQueued(shard);
+            }
+            totalTasks.add(shard);
+            if (sleepingThreads.load() > 0)
+                condition.notify_one();
+            maybeGrow();
+            return;
+        }
+
+        const WorkerContext& context = currentWorker();
+        size_t target = context.pool == this ? context.index : externalTarget();
+        if (preferredQueue != NoPreferredQueue)
+            target = preferredQueue % localQueues.size();
+        countQueued(shard);
+        localQueues[target].push(std::move(task));
+        totalTasks.add(shard);
+        wakeSleepingWorker();
+    }
+
+    // 排队计数: 先计数再发布任务, 取走任务后再减少. 无界模式只修改当前线程的分片
+    void countQueued(size_t shard, size_t count = 1)
+    {
+        pendingTasks.add(shard, count);
+        if (capacity > 0)
+            boundedTasks.fetch_add(count);
+    }
+
+    void countTaken(size_t shard, size_t count = 1)
+    {
+        if (capacity > 0)
+            boundedTasks.fetch_sub(count);
+        pendingTasks.sub(shard, count);
+    }
+
+    // 有界模式下精确, 无界模式下为各分片之和 (并发修改时近似)
+    size_t queuedTasks() const
+    {
+        return capacity > 0 ? boundedTasks.load() : pendingTasks.load();
+    }
+
+    // 有界模式下占用的容量: 排队的任务加上串行队列中积压的任务
+    size_t occupancy() const
+    {
+        return queuedTasks() + keyedTasks.load();
+    }
+
+    size_t strandSlot(size_t hash) const
+    {
+        // 混合高位, 避免连续整数 key 只落在少数几个槽位上
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash & (strandCount() - 1);
+    }
+
+    // 串行队列数: 不少于最大线程数的 16 倍, 取 2 的幂
+    size_t strandCount() const
+    {
+        return std::bit_ceil(std::max<size_t>(64, maxThreads * 16));
+    }
+
+    StrandQueue& strandAt(size_t slot)
+    {
+        // 只有使用 enqueueKeyed 的线程池才分配串行队列
+        std::call_once(strandsCreated, [this]() { strands = std::make_unique<StrandQueue[]>(strandCount()); });
+        return strands[slot];
+    }
+
+    template<typename F, typename... Args>
+    static UniqueTask bindTask(F&& f, Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+        {
+            return UniqueTask(std::forward<F>(f));
+        }
+        else
+        {
+            return UniqueTask([func = std::forward<F>(f), ... params = std::forward<Args>(args)]() mutable
+                              { std::invoke(std::move(func), std::move(params)...); });
+        }
+    }
+
+    TimerId addTimer(Clock::time_point time, Clock::duration period, UniqueTask task)
+    {
+        if (stop)
+            throw std::runtime_error("schedule on stopped ThreadPool");
+        TimerId id;
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(timerMutex);
+            if (timerStopped)
+                throw std::runtime_error("schedule on stopped ThreadPool");
+            if (!timerThread.joinable())
+                timerThread = std::thread([this]() { timerLoop(); });
+            id = period > Clock::duration::zero() ? timerWheel.addPeriodic(time, period, std::move(task))
+                                                  : timerWheel.add(time, std::move(task));
+            wake = time < timerWakeup;
+        }
+        if (wake)
+            timerCondition.notify_one();
+        return id;
+    }
+
+    // 定时器线程: 推进时间轮, 在锁外把到期任务提交给线程池, 然后睡到下一个非空槽.
+    // 到期任务绕过容量许可直接入队: Block 会让后续定时器全部延迟, CallerRuns 会在定时器线程上执行用户任务
+    void timerLoop()
+    {
+        std::vector<UniqueTask> expired;
+        std::unique_lock<std::mutex> lock(timerMutex);
+        while (!timerStopped)
+        {
+            timerWheel.advance(Clock::now(), expired);
+            if (!expired.empty())
+            {
+                lock.unlock();
+                for (UniqueTask& task : expired)
+                {
+                    try
+                    {
+                        if (stop)
+                            throw std::runtime_error("enqueue on stopped ThreadPool");
+                        publishTask(std::move(task), TaskPriority::Normal, NoPreferredQueue, false);
+                    }
+                    catch (const std::exception&)
+                    {
+                        // 线程池已停止: 丢弃本次触发
+                    }
+                }
+                expired.clear();
+                lock.lock();
+                continue;
+            }
+            const auto wakeup = timerWheel.nextWakeup();
+            timerWakeup = wakeup.value_or(Clock::time_point::max());
+            if (wakeup)
+                timerCondition.wait_until(lock, *wakeup);
+            else
+                timerCondition.wait(lock);
+            // 醒着时新加入的定时器会在下一轮计算等待时间时考虑到, 不需要通知
+            timerWakeup = Clock::time_point::min();
+        }
+    }
+
+    void stopTimers()
+    {
+        std::vector<UniqueTask> pending;
+        {
+            std::lock_guard<std::mutex> lock(timerMutex);
+            timerStopped = true;
+            timerWheel.clear(pending);
+        }
+        timerCondition.notify_one();
+        if (timerThread.joinable() && timerThread.get_id() != std::this_thread::get_id())
+            timerThread.join();
+        // 在锁外析构: 任务捕获的状态 (如 spawnAfter 的结果) 随之以 broken_promise 完成, 其回调可能再访问定时器
+        pending.clear();
+    }
+
+    // 有界模式下按 key 提交的任务在进入串行队列前按溢出策略取得许可, 串行队列中积压的任务计入容量.
+    // 串行队列的调度任务本身不受容量限制, 已接受的任务不会因为队列已满而被丢弃或改由提交线程执行
+    void pushKeyed(size_t slot, UniqueTask func)
+    {
+        if (stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        const bool callerRuns = !admitKeyed();
+        if (capacity > 0)
+            keyedTasks++;
+        if (!strandAt(slot).push(std::move(func)))
+            return;
+        // CallerRuns 且由本线程负责调度时, 先就地执行一批 (包括刚提交的任务), 剩余的照常交给工作线程
+        if (callerRuns && !drainStrandBatch(slot))
+            return;
+        scheduleStrand(slot);
+    }
+
+    // 返回 false 表示队列已满且策略为 CallerRuns. 串行队列正在执行时任务只能排在其后, 此时仍会入队
+    bool admitKeyed()
+    {
+        if (capacity == 0 || occupancy() < capacity)
+            return true;
+
+        switch (effectiveOverflowPolicy())
+        {
+        case OverflowPolicy::Block:
+            waitForSpace(1);
+            if (stop)
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            return true;
+        case OverflowPolicy::Reject:
+            rejectedTasks++;
+            throw QueueFullError("ThreadPool queue is full");
+        case OverflowPolicy::DropOldest:
+            dropOldest(1);
+            return true;
+        case OverflowPolicy::CallerRuns:
+            return false;
+        }
+        return true;
+    }
+
+    // 串行队列的调度任务, 持有该队列的执行责任. 未执行就析构 (被 shutdownNow 清空, 线程池停止后入队失败)
+    // 时交给 abandonStrand, 否则队列计数不会归零, 该槽位之后的任务永远不会再被调度
+    class StrandTicket
+    {
+    public:
+        StrandTicket(ThreadPool* pool, size_t slot)
+            : pool(pool)
+            , slot(slot)
+        {
+        }
+
+        StrandTicket(StrandTicket&& other) noexcept
+            : pool(std::exchange(other.pool, nullptr))
+            , slot(other.slot)
+        {
+        }
+
+        StrandTicket& operator=(StrandTicket&&) = delete;
+
+        ~StrandTicket()
+        {
+            if (pool)
+                pool->abandonStrand(slot);
+        }
+
+        void run()
+        {
+            std::exchange(pool, nullptr)->drainStrand(slot);
+        }
+
+    private:
+        ThreadPool* pool;
+        size_t slot;
+    };
+
+    // 调度任务绕过容量许可直接入队, 不会被拒绝或在提交线程上执行, 因此 drainStrand -> scheduleStrand 不会递归
+    void scheduleStrand(size_t slot)
+    {
+        try
+        {
+            if (stop)
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            publishTask(UniqueTask([ticket = StrandTicket(this, slot)]() mutable { ticket.run(); }),
+                        TaskPriority::Normal, slot, true);
+        }
+        catch (const std::exception&)
+        {
+            // 调度任务已随异常析构, 由 StrandTicket 负责该串行队列
+        }
+    }
+
+    void drainStrand(size_t slot)
+    {
+        if (drainStrandBatch(slot))
+            scheduleStrand(slot);
+    }
+
+    // 执行一批串行任务并归还它们占用的容量. 返回 true 表示还有任务
+    bool drainStrandBatch(size_t slot)
+    {
+        size_t executed = 0;
+        const bool more = strands[slot].drain(StrandBatch, executed);
+        releaseKeyed(executed);
+        return more;
+    }
+
+    void releaseKeyed(size_t count)
+    {
+        if (capacity == 0 || count == 0)
+            return;
+        keyedTasks -= count;
+        releaseSpace();
+    }
+
+    // 调度任务未执行就析构只发生在线程池停止时: shutdownNow 丢弃该串行队列中的任务 (future 得到 broken_promise),
+    // 计入 shutdownNow 的返回值; 正常关闭时在当前线程执行完, 保证任务不会滞留
+    void abandonStrand(size_t slot)
+    {
+        if (stopSource.stop_requested())
+        {
+            const size_t discarded = strands[slot].discard();
+            releaseKeyed(discarded);
+            discardedKeyedTasks += discarded;
+            return;
+        }
+        while (drainStrandBatch(slot))
+        {
+        }
+    }
+
+    void pushUrgentTask(UniqueTask func, Clock::time_point deadline)
+    {
+        if (stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        if (!admit(func))
+            return;
+        const size_t shard = submitterShard();
+        countQueued(shard);
+        priorityLanes.pushUrgent(TaskType{std::move(func), Clock::time_point{}, timer.sample(shard), false}, deadline);
+        totalTasks.add(shard);
+        wakeSleepingWorker();
+    }
+
+    void stopAccepting()
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(spaceMutex);
+        }
+        spaceCondition.notify_all();
+        stopTimers();
+    }
+
+    void joinWorkers()
+    {
+        {
+            // 等待进行中的扩容结束, 之后 maybeGrow 看到 stop 不会再创建线程
+            std::lock_guard<std::mutex> lock(scaleMutex);
+        }
+        for (std::thread& worker : workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    void pushTasks(std::vector<TaskType> batch)
+    {
+        std::vector<TaskType> overflow = admitBatch(batch);
+        enqueueBatch(std::move(batch));
+        for (auto& task : overflow)
+        {
+            runInline(task);
+        }
+    }
+
+    // 有界模式下的入队许可. 返回 false 表示任务已按溢出策略在提交线程上执行, 不再入队
+    bool admit(UniqueTask& func)
+    {
+        if (capacity == 0 || occupancy() < capacity)
+            return true;
+
+        switch (effectiveOverflowPolicy())
+        {
+        case OverflowPolicy::Block:
+            waitForSpace(1);
+            if (stop)
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            return true;
+        case OverflowPolicy::Reject:
+            rejectedTasks++;
+            throw QueueFullError("ThreadPool queue is full");
+        case OverflowPolicy::DropOldest:
+            dropOldest(1);
+            return true;
+        case OverflowPolicy::CallerRuns:
+        {
+            TaskType task{std::move(func), Clock::time_point{}, 0, false};
+            runInline(task);
+            return false;
+        }
+        }
+        return true;
+    }
+
+    // 整批提交的许可: 队列放不下时按策略处理, CallerRuns 返回放不下的任务, 由调用方在入队后就地执行
+    std::vector<TaskType> admitBatch(std::vector<TaskType>& batch)
+    {
+        std::vector<TaskType> overflow;
+        const size_t pending = occupancy();
+        if (capacity == 0 || pending + batch.size() <= capacity)
+            return overflow;
+
+        const size_t excess = pending + batch.size() - capacity;
+        switch (effectiveOverflowPolicy())
+        {
+        case OverflowPolicy::Block:
+            waitForSpace(batch.size());
+            break;
+        case OverflowPolicy::Reject:
+            rejectedTasks += batch.size();
+            throw QueueFullError("ThreadPool queue is full");
+        case OverflowPolicy::DropOldest:
+            dropOldest(excess);
+            break;
+        case OverflowPolicy::CallerRuns:
+        {
+            const size_t keep = batch.size() - std::min(excess, batch.size());
+            overflow.insert(overflow.end(), std::make_move_iterator(batch.begin() + keep),
+                            std::make_move_iterator(batch.end()));
+            batch.erase(batch.begin() + keep, batch.end());
+            break;
+        }
+        }
+        return overflow;
+    }
+
+    // 工作线程向本线程池阻塞提交可能导致所有工作线程互相等待, 此时改为由提交线程直接执行
+    OverflowPolicy effectiveOverflowPolicy() const
+    {
+        if (overflowPolicy == OverflowPolicy::Block && currentWorker().pool == this)
+            return OverflowPolicy::CallerRuns;
+        return overflowPolicy;
+    }
+
+    // 等待排队任务数降到能放下 count 个任务, 一批任务超过容量时等待队列清空
+    void waitForSpace(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(spaceMutex);
+        spaceWaiters++;
+        spaceCondition.wait(lock,
+                            [this, count]
+                            {
+                                const size_t pending = occupancy();
+                                return stop || pending + count <= capacity || pending == 0;
+                            });
+        spaceWaiters--;
+    }
+
+    // 工作线程取走任务后唤醒等待空位的线程, 与等待方先增加 spaceWaiters 再检查队列长度配对
+    void releaseSpace()
+    {
+        if (spaceWaiters.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(spaceMutex);
+            }
+            spaceCondition.notify_all();
+        }
+    }
+
+    // 丢弃最多 count 个最早排队的普通任务, 普通任务不够时再丢弃低优先级任务. 紧急通道中的任务不会被丢弃
+    void dropOldest(size_t count)
+    {
+        droppedTasks += takeOldest(count, false).size();
+        // 被丢弃的任务在这里析构, 不持有任何队列锁; 析构可能使协助线程等待的结果就绪
+        notifyHelpers();
+    }
+
+    // 从队列中取出最多 count 个任务: 普通任务 -> 低优先级通道 -> 紧急通道 (includeUrgent 时)
+    std::vector<TaskType> takeOldest(size_t count, bool includeUrgent)
+    {
+        std::vector<TaskType> victims;
+        std::vector<TaskType> kept;
+        TaskType task;
+        const size_t shard = submitterShard();
+        while (victims.size() < count)
+        {
+            bool dropped = false;
+            if (mode == SchedulingMode::SharedQueue)
+            {
+                dropped = tryPopShared(shard, task);
+            }
+            else
+            {
+                const size_t first = nextQueue.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < localQueues.size() && !dropped; ++i)
+                {
+                    if (localQueues[(first + i) % localQueues.size()].steal(task))
+                    {
+                        countTaken(shard);
+                        dropped = true;
+                    }
+                }
+            }
+            if (!dropped && priorityLanes.tryPopLow(task))
+            {
+                countTaken(shard);
+                dropped = true;
+            }
+            if (!dropped && includeUrgent && priorityLanes.tryPopUrgent(task, Clock::time_point::max()))
+            {
+                countTaken(shard);
+                dropped = true;
+            }
+            if (!dropped)
+                break;
+            if (task.pinned && !includeUrgent)
+                kept.push_back(std::move(task));
+            else
+                victims.push_back(std::move(task));
+        }
+        // DropOldest 不丢弃串行队列的调度任务, 取出后放回队尾; 其中的任务已经被接受, 只在 shutdownNow 时丢弃
+        for (TaskType& pinned : kept)
+        {
+            try
+            {
+                publishTask(std::move(pinned.func), TaskPriority::Normal, NoPreferredQueue, true);
+            }
+            catch (const std::exception&)
+            {
+                // 线程池已停止: 调度任务随异常析构, 由 StrandTicket 负责该串行队列
+            }
+        }
+        if (!victims.empty())
+            releaseSpace();
+        return victims;
+    }
 
+    // 在提交线程上执行任务, 统计计入该线程所属的分片 (池外线程使用最后一个分片)
+    void runInline(TaskType& task)
+    {
+        const size_t shard = submitterShard();
+        task.enqueueStamp = timer.sample(shard);
+        totalTasks.add(shard);
+        runTask(task, shard);
+    }
+
+    void enqueueBatch(std::vector<TaskType> batch)
+    {
+        const size_t count = batch.size();
+        if (count == 0)
+            return;
+        // 整批任务共用一次时钟读取
+        const size_t shard = submitterShard();
+        uint64_t stamp = 0;
+        for (auto& task : batch)
+        {
+            if (timer.shouldSample(shard))
+            {
+                if (stamp == 0)
+                    stamp = timer.now();
+                task.enqueueStamp = stamp;
+            }
+        }
+
+        if (mode == SchedulingMode::SharedQueue)
+        {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                if (stop)
+                    throw std::runtime_error("enqueue on stopped ThreadPool");
+                for (auto& task : batch)
+                {
+                    tasks.push_back(std::move(task));
+                }
+                countQueued(shard, count);
+            }
+            totalTasks.add(shard, count);
+            if (sleepingThreads.load() > 0)
+                notifyWorkers(count);
+            maybeGrow();
+            return;
+        }
+
+        if (stop)
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+
+        // 工作线程内提交的整批任务放入本地队列由其它线程窃取; 外部提交则按块均分到各个队列
+        countQueued(shard, count);
+        const WorkerContext& context = currentWorker();
+        if (context.pool == this)
+        {
+            localQueues[context.index].pushBulk(std::make_move_iterator(batch.begin()),
+                                                std::make_move_iterator(batch.end()));
+        }
+        else
+        {
+            const size_t queueCount = std::min(count, localQueues.size());
+            const size_t first = nextQueue.fetch_add(queueCount, std::memory_order_relaxed);
+            auto begin = batch.begin();
+            for (size_t i = 0; i < queueCount; ++i)
+            {
+                auto end = begin + (count / queueCount + (i < count % queueCount ? 1 : 0));
+                localQueues[(first + i) % localQueues.size()].pushBulk(std::make_move_iterator(begin),
+                                                                         std::make_move_iterator(end));
+                begin = end;
+            }
+        }
+        totalTasks.add(shard, count);
+        if (sleepingThreads.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+            }
+            notifyWorkers(count);
+        }
+        maybeGrow();
+    }
+
+    void notifyWorkers(size_t count)
+    {
+        if (count >= workers.size())
+        {
+            condition.notify_all();
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            condition.notify_one();
+        }
+    }
+
+    // 只有存在休眠线程时才进入互斥区并唤醒, 与 waitForTask 中的 sleepingThreads 计数配对避免丢失唤醒
+    void wakeSleepingWorker()
+    {
+        if (sleepingThreads.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+            }
+            condition.notify_one();
+        }
+        maybeGrow();
+    }
+
+    ScalingMetrics collectMetrics() const
+    {
+        ScalingMetrics metrics;
+        metrics.threadCount = liveThreads;
+        metrics.minThreads = minThreads;
+        metrics.maxThreads = maxThreads;
+        metrics.idleThreads = idleThreads;
+        metrics.activeThreads = activeThreads;
+        metrics.queueDepth = queuedTasks();
+        uint64_t recentWait = 0;
+        for (const auto& shard : workerStats)
+        {
+            recentWait = std::max(recentWait, shard.lastQueueWait.load(std::memory_order_relaxed));
+        }
+        metrics.recentQueueWait = std::chrono::nanoseconds(recentWait);
+        return metrics;
+    }
+
+    // 提交任务后检查是否需要扩容: 只有排队任务多于空闲线程时才会进入, 没有存活线程时无条件扩容
+    void maybeGrow()
+    {
+        if (!elastic || queuedTasks() <= idleThreads.load() || stop)
+            return;
+
+        std::unique_lock<std::mutex> lock(scaleMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            if (liveThreads.load() > 0)
+                return;
+            lock.lock();
+        }
+        if (stop || liveThreads >= maxThreads)
+            return;
+        if (liveThreads > 0 && !scalingPolicy->shouldGrow(collectMetrics()))
+            return;
+
+        for (size_t slot = 0; slot < maxThreads; ++slot)
+        {
+            if (!workerAlive[slot])
+            {
+                if (workers[slot].joinable())
+                    workers[slot].join();
+                startWorker(slot);
+                return;
+            }
+        }
+    }
+
+    // 调用方需持有 scaleMutex (构造函数中除外)
+    void startWorker(size_t slot)
+    {
+        workerAlive[slot] = true;
+        liveThreads++;
+        idleThreads++;
+        workers[slot] = std::thread([this, slot]() { workerLoop(slot); });
+    }
+
+    // 空闲超时的工作线程尝试退出; 先减少计数再检查队列, 与提交方的 maybeGrow 配对, 避免任务无线程处理
+    bool tryRetire(size_t slot)
+    {
+        std::lock_guard<std::mutex> lock(scaleMutex);
+        if (stop || liveThreads <= minThreads || !scalingPolicy->shouldRetire(collectMetrics()))
+            return false;
+
+        liveThreads--;
+        idleThreads--;
+        if (queuedTasks() > 0)
+        {
+            liveThreads++;
+            idleThreads++;
+            return false;
+        }
+        workerAlive[slot] = false;
+        return true;
+    }
+
+    bool tryPopLocal(size_t index, TaskType& task)
+    {
+        if (localQueues[index].pop(task))
+        {
+            countTaken(index);
+            return true;
+        }
+        return false;
+    }
+
+    bool trySteal(size_t index, TaskType& task)
+    {
+        for (size_t victim : stealOrder[index])
+        {
+            if (localQueues[victim].steal(task))
+            {
+                countTaken(index);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 每个工作线程的窃取顺序: 从下一个队列开始环形遍历; 按 NUMA 节点分区时先遍历同节点的队列
+    void buildStealOrder()
+    {
+        const size_t count = localQueues.size();
+        stealOrder.resize(count);
+        for (size_t index = 0; index < count; ++index)
+        {
+            for (size_t offset = 1; offset < count; ++offset)
+            {
+                stealOrder[index].push_back((index + offset) % count);
+            }
+            if (affinity.partitioned())
+            {
+                std::stable_partition(stealOrder[index].begin(), stealOrder[index].end(),
+                                      [this, index](size_t victim)
+                                      { return affinity.nodeOf(victim) == affinity.nodeOf(index); });
+            }
+        }
+
+        if (affinity.partitioned())
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                const auto node = static_cast<size_t>(affinity.nodeOf(index));
+                if (nodeQueues.size() <= node)
+                    nodeQueues.resize(node + 1);
+                nodeQueues[node].push_back(index);
+            }
+        }
+    }
+
+    // 池外线程提交的任务轮流放入各队列; 按 NUMA 节点分区时只在提交线程所在节点的队列间轮转
+    size_t externalTarget()
+    {
+        const size_t ticket = nextQueue.fetch_add(1, std::memory_order_relaxed);
+        if (!nodeQueues.empty())
+        {
+            const int node = CpuTopology::currentNode();
+            if (node >= 0 && static_cast<size_t>(node) < nodeQueues.size() && !nodeQueues[node].empty())
+                return nodeQueues[node][ticket % nodeQueues[node].size()];
+        }
+        return ticket % localQueues.size();
+    }
+
+    bool tryPopShared(size_t shard, TaskType& task)
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        countTaken(shard);
+        return true;
+    }
+
+    // 每取走一个任务就唤醒等待空位的提交线程或等待排空的关闭线程
+    bool tryPopTask(size_t index, TaskType& task)
+    {
+        if (!tryPopQueued(index, task))
+            return false;
+        releaseSpace();
+        return true;
+    }
+
+    // 取任务顺序: 紧急通道 (含老化的低优先级任务) -> 普通任务 -> 低优先级通道
+    bool tryPopQueued(size_t index, TaskType& task)
+    {
+        if (priorityLanes.size() > 0 && priorityLanes.tryPopUrgent(task, Clock::now()))
+        {
+            countTaken(index);
+            return true;
+        }
+
+        const bool popped = mode == SchedulingMode::SharedQueue ? tryPopShared(index, task)
+                                                                : tryPopLocal(index, task) || trySteal(index, task);
+        if (popped)
+            return true;
+
+        if (priorityLanes.tryPopLow(task))
+        {
+            countTaken(index);
+            return true;
+        }
+        return false;
+    }
+
+    bool waitForTask(size_t index, TaskType& task)
+    {
+        while (true)
+        {
+            if (tryPopTask(index, task))
+                return true;
+
+            // 休眠前按等待策略自旋, 自旋中的线程不计入 sleepingThreads, 提交方无需唤醒
+            if (waitStrategy.mode != WaitMode::Block)
+            {
+                const auto idleDeadline = elastic ? Clock::now() + idleTimeout : Clock::time_point::max();
+                const bool ready = spinUntil(
+                    waitStrategy,
+                    [&]
+                    {
+                        return stop.load(std::memory_order_relaxed) ||
+                               (queuedTasks() > 0 && tryPopTask(index, task));
+                    },
+                    [&] { return Clock::now() >= idleDeadline; });
+                if (task.func)
+                    return true;
+                if (ready)
+                {
+                    if (stop && queuedTasks() == 0)
+                        return false;
+                    continue;
+                }
+                // 忙轮询模式不休眠, 只在弹性模式下空闲超时后尝试退出
+                if (waitStrategy.mode == WaitMode::BusyPoll)
+                {
+                    if (tryRetire(index))
+                        return false;
+                    continue;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            sleepingThreads++;
+            auto hasWork = [this] { return stop || queuedTasks() > 0; };
+            bool woken = true;
+            if (elastic)
+                woken = condition.wait_for(lock, idleTimeout, hasWork);
+            else
+                condition.wait(lock, hasWork);
+            sleepingThreads--;
+            if (stop && queuedTasks() == 0)
+                return false;
+            if (!woken)
+            {
+                lock.unlock();
+                if (tryRetire(index))
+                    return false;
+            }
+        }
+    }
+
+    void workerLoop(size_t index)
+    {
+        currentWorker() = WorkerContext{this, index};
+        affinity.applyToCurrentThread(index);
+        // 空闲/活跃计数只在状态切换时修改: 连续取到任务的工作线程保持活跃, 不为每个任务修改共享计数
+        bool active = false;
+        while (true)
+        {
+            TaskType task;
+            if (!tryPopTask(index, task))
+            {
+                if (active)
+                {
+                    activeThreads--;
+                    idleThreads++;
+                    active = false;
+                }
+                if (!waitForTask(index, task))
+                    return;
+            }
+            if (!active)
+            {
+                idleThreads--;
+                activeThreads++;
+                active = true;
+            }
+            runTask(task, index);
+        }
+    }
+
+    // 未采样的任务不读取时钟, 也不更新统计
+    void runTask(TaskType& task, size_t shard)
+    {
+        if (task.enqueueStamp == 0)
+        {
+            invokeTask(task);
+            notifyHelpers();
+            return;
+        }
+
+        const uint64_t start = timer.now();
+        invokeTask(task);
+        const uint64_t end = timer.now();
+        notifyHelpers();
+
+        WorkerStats& stats = workerStats[shard];
+        const uint64_t queueWait = timer.toNanoseconds(task.enqueueStamp, start);
+        stats.queueWait.record(queueWait);
+        stats.execution.record(timer.toNanoseconds(start, end));
+        stats.lastQueueWait.store(queueWait, std::memory_order_relaxed);
+    }
+
+    static void invokeTask(TaskType& task)
+    {
+        try
+        {
+            task.func();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Exception in ThreadPool task: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "Unknown exception in ThreadPool task" << std::endl;
+        }
+        task.func.reset();
+    }
+
+    const SchedulingMode mode;
+    const bool elastic;
+    const size_t minThreads;
+    const size_t maxThreads;
+    const std::chrono::milliseconds idleTimeout;
+    const std::shared_ptr<IScalingPolicy> scalingPolicy;
+    const AffinityPlan affinity;
+    const WaitStrategy waitStrategy;
+    const size_t capacity;
+    const OverflowPolicy overflowPolicy;
+    const TaskTimer timer;
+    RingDeque<TaskType> tasks;
+    std::vector<WorkStealingQueue<TaskType>> localQueues;
+    std::vector<std::vector<size_t>> stealOrder;
+    std::vector<std::vector<size_t>> nodeQueues;  // NUMA 节点编号 -> 该节点的队列下标
+
+    // 共享队列模式下保护 tasks, 同时用于线程休眠与唤醒
     mutable std::mutex queue_mutex;
-    mutable std::mutex stats_mutex;
     std::condition_variable condition;
     std::atomic<bool> stop;
     std::atomic<size_t> idleThreads;
     std::atomic<size_t> activeThreads;
-    std::atomic<size_t> totalTasks;
+    // 每个任务都要修改的计数按提交/取出任务的线程分片 (分片规则同 submitterShard), 避免工作线程争用同一缓存行.
+    // 分片求和在并发修改时只是近似值, 有界模式的容量判断需要精确值, 因此另外维护 boundedTasks
+    ShardedCounter totalTasks;
+    ShardedCounter pendingTasks;
+    std::atomic<size_t> boundedTasks{0};
+    std::atomic<size_t> sleepingThreads;
+    std::atomic<size_t> nextQueue;
+    std::atomic<size_t> liveThreads;
 
-    double totalTaskTime = 0;
-    double minTaskTime = std::numeric_limits<double>::max();
-    double maxTaskTime = 0;
+    // 有界模式下等待空位的提交线程, 以及等待队列排空的关闭线程
+    std::mutex spaceMutex;
+    std::condition_variable spaceCondition;
+    std::atomic<size_t> spaceWaiters{0};
+    std::atomic<size_t> rejectedTasks{0};
+    std::atomic<size_t> droppedTasks{0};
+    // 有界模式下串行队列中积压的任务数; shutdownNow 从串行队列中丢弃的任务数
+    std::atomic<size_t> keyedTasks{0};
+    std::atomic<size_t> discardedKeyedTasks{0};
 
-    void updateStats(double taskTime)
-    {
-        std::unique_lock<std::mutex> lock(stats_mutex);
-        totalTaskTime += taskTime;
-        minTaskTime = std::min(minTaskTime, taskTime);
-        maxTaskTime = std::max(maxTaskTime, taskTime);
-    }
+    // 弹性模式下按槽位管理工作线程, 槽位数为 maxThreads; 退出的线程在槽位被复用或析构时回收
+    std::mutex scaleMutex;
+    std::vector<std::thread> workers;
+    std::vector<bool> workerAlive;
+    std::vector<WorkerStats> workerStats;
+    PriorityLanes<TaskType> priorityLanes;
+    std::stop_source stopSource;
+
+    // helpUntil 在没有可执行任务时先让出 CPU 的次数, 之后休眠等待唤醒; helpingThreads 为休眠中的协助线程数
+    static constexpr size_t HelpSpinRounds = 64;
+    static constexpr std::chrono::microseconds HelpParkMin{50};
+    static constexpr std::chrono::microseconds HelpParkMax{2000};
+    std::atomic<size_t> helpingThreads{0};
+
+    // enqueueKeyed 的串行队列, 首次使用时分配. 每次调度最多连续执行 StrandBatch 个任务
+    static constexpr size_t StrandBatch = 64;
+    std::once_flag strandsCreated;
+    std::unique_ptr<StrandQueue[]> strands;
+
+    // 定时任务. timerWakeup 是定时器线程当前睡到的时间, 新定时器更早到期时才需要唤醒它
+    mutable std::mutex timerMutex;
+    std::condition_variable timerCondition;
+    TimerWheel timerWheel;
+    Clock::time_point timerWakeup = Clock::time_point::max();
+    bool timerStopped = false;
+    std::thread timerThread;
 };
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "UniqueTask.hpp"
+
+// scheduleAfter/scheduleAt/scheduleEvery 返回的定时器标识, 用于 cancelTimer. 一次性定时器触发或取消后标识失效
+struct TimerId
+{
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool operator==(const TimerId&) const = default;
+};
+
+// 分层时间轮: 4 层, 每层 256 个槽, 刻度 1ms, 覆盖约 49 天, 更远的定时器先停在最高层, 轮转到时重新放置.
+// 每个槽是定时器条目的双向链表, 插入与取消都是 O(1); 下层转完一圈时把上一层对应槽中的定时器按剩余时间
+// 重新分配到下层 (cascade). 条目存放在按下标复用的数组中, 代号 (generation) 防止过期的 TimerId 取消到新定时器.
+// 本身不加锁, 由调用方负责同步
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr Clock::duration Resolution = std::chrono::milliseconds(1);
+
+    explicit TimerWheel(Clock::time_point origin = Clock::now())
+        : origin(origin)
+    {
+        slots.fill(Nil);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId add(Clock::time_point deadline, UniqueTask task)
+    {
+        const uint32_t index = allocate();
+        Entry& entry = entries[index];
+        entry.task = std::move(task);
+        entry.deadline = std::max(ceilTick(deadline), current + 1);
+        place(index);
+        return TimerId{index, entry.generation};
+    }
+
+    // 周期定时器: 首次在 first 触发, 之后每隔 period 触发. 同一定时器的上一次执行尚未结束时跳过本次
+    TimerId addPeriodic(Clock::time_point first, Clock::duration period, UniqueTask task)
+    {
+        const uint32_t index = allocate();
+        Entry& entry = entries[index];
+        entry.periodic = std::make_shared<PeriodicTask>(std::move(task));
+        entry.period = std::max<uint64_t>(1, ceilTick(origin + period));
+        entry.deadline = std::max(ceilTick(first), current + 1);
+        place(index);
+        return TimerId{index, entry.generation};
+    }
+
+    bool cancel(TimerId id)
+    {
+        if (id.index >= entries.size())
+            return false;
+        Entry& entry = entries[id.index];
+        if (entry.generation != id.generation || entry.slot == Nil)
+            return false;
+        unlink(id.index);
+        release(id.index);
+        return true;
+    }
+
+    // 推进到 time, 到期的任务追加到 expired. 周期定时器重新放入下一次触发时间, 错过的周期直接跳过
+    void advance(Clock::time_point time, std::vector<UniqueTask>& expired)
+    {
+        const uint64_t target = floorTick(time);
+        while (current < target)
+        {
+            if (count == 0)
+            {
+                current = target;
+                break;
+            }
+            ++current;
+            // 从高层到低层 cascade, 高层落下来的定时器可能正好落在本刻度要 cascade 的下层槽中
+            unsigned levels = 0;
+            while (levels + 1 < Levels && (current & ((uint64_t{1} << (SlotBits * (levels + 1))) - 1)) == 0)
+            {
+                ++levels;
+            }
+            for (unsigned level = levels; level > 0; --level)
+            {
+                cascade(level * Slots + ((current >> (SlotBits * level)) & SlotMask));
+            }
+            expire(current & SlotMask, expired);
+        }
+    }
+
+    // 下一次需要推进的时间: 最近的非空槽, 或下层转完一圈需要 cascade 的时刻. 没有定时器时返回 nullopt
+    std::optional<Clock::time_point> nextWakeup() const
+    {
+        if (count == 0)
+            return std::nullopt;
+        uint64_t tick = current + 1;
+        while (slots[tick & SlotMask] == Nil && (tick & SlotMask) != 0)
+        {
+            ++tick;
+        }
+        return origin + Resolution * tick;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    // 移除所有定时器, 任务移到 dropped 中由调用方在锁外析构
+    void clear(std::vector<UniqueTask>& dropped)
+    {
+        for (uint32_t index = 0; index < entries.size(); ++index)
+        {
+            Entry& entry = entries[index];
+            if (entry.slot == Nil)
+                continue;
+            if (entry.periodic)
+                dropped.push_back(UniqueTask([periodic = std::move(entry.periodic)]() {}));
+            else
+                dropped.push_back(std::move(entry.task));
+            unlink(index);
+            release(index);
+        }
+    }
+
+private:
+    static constexpr unsigned Levels = 4;
+    static constexpr unsigned SlotBits = 8;
+    static constexpr uint64_t Slots = uint64_t{1} << SlotBits;
+    static constexpr uint64_t SlotMask = Slots - 1;
+    static constexpr uint32_t Nil = std::numeric_limits<uint32_t>::max();
+
+    // 周期任务在线程池上可能晚于下一次触发才执行完, running 保证同一任务不会并发执行
+    struct PeriodicTask
+    {
+        explicit PeriodicTask(UniqueTask task)
+            : task(std::move(task))
+        {
+        }
+
+        void run()
+        {
+            if (running.exchange(true, std::memory_order_acquire))
+                return;
+            struct Reset
+            {
+                std::atomic<bool>& flag;
+                ~Reset()
+                {
+                    flag.store(false, std::memory_order_release);
+                }
+            } reset{running};
+            task();
+        }
+
+        UniqueTask task;
+        std::atomic<bool> running{false};
+    };
+
+    struct Entry
+    {
+        UniqueTask task;
+        std::shared_ptr<PeriodicTask> periodic;
+        uint64_t deadline = 0;
+        uint64_t period = 0;
+        uint32_t prev = Nil;
+        uint32_t next = Nil;  // 空闲条目借用 next 串成空闲链表
+        uint32_t slot = Nil;
+        uint32_t generation = 0;
+    };
+
+    uint64_t floorTick(Clock::time_point time) const
+    {
+        return time <= origin ? 0 : static_cast<uint64_t>((time - origin) / Resolution);
+    }
+
+    // 定时器只会晚于截止时间触发, 不会提前
+    uint64_t ceilTick(Clock::time_point time) const
+    {
+        return time <= origin ? 0 : static_cast<uint64_t>((time - origin + Resolution - Clock::duration(1)) / Resolution);
+    }
+
+    uint32_t allocate()
+    {
+        uint32_t index = freeHead;
+        if (index != Nil)
+        {
+            freeHead = entries[index].next;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        ++count;
+        return index;
+    }
+
+    void release(uint32_t index)
+    {
+        Entry& entry = entries[index];
+        entry.task.reset();
+        entry.periodic.reset();
+        entry.period = 0;
+        entry.slot = Nil;
+        entry.prev = Nil;
+        entry.next = freeHead;
+        entry.generation++;
+        freeHead = index;
+        --count;
+    }
+
+    // 按剩余刻度选择层: 剩余不足 256 放第 0 层, 不足 65536 放第 1 层, 依此类推
+    void place(uint32_t index)
+    {
+        Entry& entry = entries[index];
+        uint64_t deadline = std::max(entry.deadline, current);
+        const uint64_t remaining = deadline - current;
+        unsigned level = 0;
+        while (level + 1 < Levels && remaining >= (uint64_t{1} << (SlotBits * (level + 1))))
+        {
+            ++level;
+        }
+        if (remaining >= (uint64_t{1} << (SlotBits * Levels)))
+            deadline = current + (uint64_t{1} << (SlotBits * Levels)) - 1;
+
+        const uint32_t slot = static_cast<uint32_t>(level * Slots + ((deadline >> (SlotBits * level)) & SlotMask));
+        entry.slot = slot;
+        entry.prev = Nil;
+        entry.next = slots[slot];
+        if (entry.next != Nil)
+            entries[entry.next].prev = index;
+        slots[slot] = index;
+    }
+
+    void unlink(uint32_t index)
+    {
+        Entry& entry = entries[index];
+        if (entry.prev != Nil)
+            entries[entry.prev].next = entry.next;
+        else
+            slots[entry.slot] = entry.next;
+        if (entry.next != Nil)
+            entries[entry.next].prev = entry.prev;
+        entry.slot = Nil;
+    }
+
+    uint32_t detach(uint32_t slot)
+    {
+        const uint32_t head = slots[slot];
+        slots[slot] = Nil;
+        return head;
+    }
+
+    void cascade(uint32_t slot)
+    {
+        uint32_t index = detach(slot);
+        while (index != Nil)
+        {
+            const uint32_t next = entries[index].next;
+            place(index);
+            index = next;
+        }
+    }
+
+    void expire(uint32_t slot, std::vector<UniqueTask>& expired)
+    {
+        uint32_t index = detach(slot);
+        while (index != Nil)
+        {
+            Entry& entry = entries[index];
+            const uint32_t next = entry.next;
+            if (entry.deadline > current)
+            {
+                place(index);
+            }
+            else if (entry.periodic)
+            {
+                expired.push_back(UniqueTask([periodic = entry.periodic]() { periodic->run(); }));
+                entry.deadline += ((current - entry.deadline) / entry.period + 1) * entry.period;
+                place(index);
+            }
+            else
+            {
+                expired.push_back(std::move(entry.task));
+                release(index);
+            }
+            index = next;
+        }
+    }
+
+    const Clock::time_point origin;
+    uint64_t current = 0;
+    size_t count = 0;
+    uint32_t freeHead = Nil;
+    std::array<uint32_t, Levels * Slots> slots;
+    std::vector<Entry> entries;
+};
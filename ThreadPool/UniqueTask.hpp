@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 只可移动的 void() 可调用对象包装, 带小对象优化:
+// 不超过 InlineSize 且可无异常移动的可调用对象直接存放在内部缓冲区, 不产生堆分配.
+class UniqueTask
+{
+public:
+    static constexpr size_t InlineSize = 48;
+
+    UniqueTask() noexcept = default;
+
+    template<typename F>
+        requires(!std::is_same_v<std::decay_t<F>, UniqueTask> && std::is_invocable_v<std::decay_t<F>&>)
+    UniqueTask(F&& func)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (fitsInline<Callable>())
+        {
+            ::new (static_cast<void*>(storage)) Callable(std::forward<F>(func));
+            ops = &InlineOperations<Callable>::table;
+        }
+        else
+        {
+            ::new (static_cast<void*>(storage)) Callable*(new Callable(std::forward<F>(func)));
+            ops = &HeapOperations<Callable>::table;
+        }
+    }
+
+    UniqueTask(UniqueTask&& other) noexcept
+        : ops(other.ops)
+    {
+        if (ops)
+        {
+            ops->move(storage, other.storage);
+            other.ops = nullptr;
+        }
+    }
+
+    UniqueTask& operator=(UniqueTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.ops)
+            {
+                other.ops->move(storage, other.storage);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueTask(const UniqueTask&) = delete;
+    UniqueTask& operator=(const UniqueTask&) = delete;
+
+    ~UniqueTask()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return ops != nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (ops)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    template<typename F>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<F>;
+    }
+
+private:
+    struct Operations
+    {
+        void (*invoke)(void* self);
+        void (*move)(void* destination, void* source) noexcept;
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template<typename F>
+    struct InlineOperations
+    {
+        static F& get(void* self)
+        {
+            return *std::launder(static_cast<F*>(self));
+        }
+
+        static void invoke(void* self)
+        {
+            std::invoke(get(self));
+        }
+
+        static void move(void* destination, void* source) noexcept
+        {
+            ::new (destination) F(std::move(get(source)));
+            get(source).~F();
+        }
+
+        static void destroy(void* self) noexcept
+        {
+            get(self).~F();
+        }
+
+        static constexpr Operations table{&invoke, &move, &destroy};
+    };
+
+    template<typename F>
+    struct HeapOperations
+    {
+        static F*& get(void* self)
+        {
+            return *std::launder(static_cast<F**>(self));
+        }
+
+        static void invoke(void* self)
+        {
+            std::invoke(*get(self));
+        }
+
+        static void move(void* destination, void* source) noexcept
+        {
+            ::new (destination) F*(get(source));
+        }
+
+        static void destroy(void* self) noexcept
+        {
+            delete get(self);
+        }
+
+        static constexpr Operations table{&invoke, &move, &destroy};
+    };
+
+    alignas(std::max_align_t) std::byte storage[InlineSize];
+    const Operations* ops = nullptr;
+};
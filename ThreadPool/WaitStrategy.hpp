@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(_M_ARM)
+#include <intrin.h>
+#endif
+
+enum class WaitMode
+{
+    Block,         // 没有任务时立即在条件变量上休眠, 不占用 CPU, 唤醒需要一次 futex 系统调用
+    SpinThenPark,  // 先用 pause 指令自旋, 再让出时间片, 仍没有任务才休眠
+    BusyPoll,      // 一直轮询不休眠, 唤醒延迟最低, 但每个空闲线程占满一个核心
+};
+
+// 空闲工作线程的等待方式. 自旋中的线程不计入休眠线程数, 提交方看到没有休眠线程时不会发出唤醒.
+struct WaitStrategy
+{
+    WaitMode mode = WaitMode::Block;
+    size_t spinIterations = 4096;  // pause 自旋次数, 约几十微秒
+    size_t yieldIterations = 64;   // 之后 std::this_thread::yield 的次数
+};
+
+// 自旋等待提示: 降低功耗, 并让出超线程兄弟核的执行资源
+inline void cpuRelax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#elif defined(_M_ARM64) || defined(_M_ARM)
+    __yield();
+#endif
+}
+
+// 按 strategy 自旋直到 ready() 为真. 返回 false 表示自旋预算用完, 调用方应转入休眠;
+// BusyPoll 模式下只有 ready() 为真或 giveUp() 为真时才返回.
+template<typename Ready, typename GiveUp>
+bool spinUntil(const WaitStrategy& strategy, Ready&& ready, GiveUp&& giveUp)
+{
+    if (strategy.mode == WaitMode::Block)
+        return false;
+
+    // 单核机器上自旋只会拖延提交方, 直接从让出时间片阶段开始
+    static const bool singleCore = std::thread::hardware_concurrency() <= 1;
+    const size_t spinIterations = singleCore ? 0 : strategy.spinIterations;
+
+    for (size_t iteration = 0;; ++iteration)
+    {
+        if (ready())
+            return true;
+        if (strategy.mode == WaitMode::BusyPoll)
+        {
+            // 每轮询一段时间让出一次, 避免在超额订阅的机器上饿死其它线程
+            if ((iteration & 63) == 63)
+            {
+                if (giveUp())
+                    return false;
+                std::this_thread::yield();
+            }
+            else
+            {
+                cpuRelax();
+            }
+        }
+        else if (iteration < spinIterations)
+        {
+            cpuRelax();
+        }
+        else if (iteration < spinIterations + strategy.yieldIterations)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include "RingDeque.hpp"
+
+// 工作窃取用的双端队列: 所属线程在尾部 push/pop (LIFO, 缓存友好),
+// 窃取者从头部取走最早入队的任务. 每个队列独占一个缓存行, 锁只在同一队列上竞争.
+template<typename T>
+class alignas(64) WorkStealingQueue
+{
+public:
+    void push(T item)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(std::move(item));
+    }
+
+    template<typename Iterator>
+    void pushBulk(Iterator first, Iterator last)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (; first != last; ++first)
+        {
+            items.push_back(*first);
+        }
+    }
+
+    bool pop(T& item)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty())
+            return false;
+        item = std::move(items.back());
+        items.pop_back();
+        return true;
+    }
+
+    bool steal(T& item)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    mutable std::mutex mutex;
+    RingDeque<T> items;
+};
@@ -2,7 +2,6 @@
 #include <array>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
-#include <execution>
 #include <fstream>
 #include <future>
 #include <iomanip>
@@ -22,8 +21,10 @@
 #include "ObjectFactory.hpp"
 #include "Observer.hpp"
 #include "OpenCLWrapper.hpp"
+#include "ParallelAlgorithms.hpp"
 #include "Singleton.hpp"
 #include "StateMachine.hpp"
+#include "TaskGraph.hpp"
 #include "TemplateClassDemo.hpp"
 #include "ThreadPool.hpp"
 #include "ThreadPoolInvokeStrategy.hpp"
@@ -84,9 +85,8 @@ std::optional<std::string> replaceCommandWithString(std::string& messageText)
     return extracted->second;
 }
 
-int longOperation(int id, std::chrono::milliseconds duration)
+int longOperation(int id)
 {
-    std::this_thread::sleep_for(duration);
     return id * 10;
 }
 
@@ -120,14 +120,14 @@ void testStateMachine(LoggerWrapper& logger)
     sm.process(StateMachine_<void>::Event2{"Internal"});
 }
 
-void complexTestSubscriberSystem(LoggerWrapper& logger)
+void complexTestSubscriberSystem(LoggerWrapper& logger, ThreadPool& pool)
 {
     try
     {
         LOG_INFO(logger, "Starting complex subscriber system test");
 
-        // 创建线程池和调用策略
-        comm::ThreadPoolInvokeStrategy strategy(16);  // 使用16个线程
+        // 调用策略复用进程内共享的线程池, 不再额外创建线程
+        comm::ThreadPoolInvokeStrategy strategy(pool);
 
         // 创建多个事件和属性
         comm::Event<int, std::string> intStringEvent(strategy);
@@ -311,28 +311,36 @@ void complexTestSubscriberSystem(LoggerWrapper& logger)
 void testThreadPool(LoggerWrapper& logger)
 {
     ThreadPool pool(4);
-    std::vector<std::future<int>> results;
+    std::vector<TaskFuture<int>> results;
 
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(100, 2000);
 
+    // 任务在随机延迟后执行, 结果在后续任务中输出. 延迟由定时器线程等待, 主线程只在最后等待一次, 不占用工作线程
     for (int i = 0; i < 20; ++i)
     {
-        results.emplace_back(pool.enqueue(longOperation, i, std::chrono::milliseconds(dis(gen))));
+        results.emplace_back(spawnAfter(pool, std::chrono::milliseconds(dis(gen)), longOperation, i)
+                                 .then(
+                                     [&logger, &pool, i](const int& result)
+                                     {
+                                         LOG_INFO(logger, "Task " + std::to_string(i) +
+                                                              " result: " + std::to_string(result) +
+                                                              ", Queue size: " + std::to_string(pool.getQueueSize()) +
+                                                              ", Idle threads: " + std::to_string(pool.getIdleThreads()) +
+                                                              ", Active threads: " +
+                                                              std::to_string(pool.getActiveThreads()));
+                                         return result;
+                                     }));
         LOG_INFO(logger, "Task " + std::to_string(i) +
                              " submitted. Queue size: " + std::to_string(pool.getQueueSize()) +
                              ", Idle threads: " + std::to_string(pool.getIdleThreads()) +
                              ", Active threads: " + std::to_string(pool.getActiveThreads()));
     }
 
-    for (size_t i = 0; i < results.size(); ++i)
-    {
-        LOG_INFO(logger, "Task " + std::to_string(i) + " result: " + std::to_string(results[i].get()) +
-                             ", Queue size: " + std::to_string(pool.getQueueSize()) +
-                             ", Idle threads: " + std::to_string(pool.getIdleThreads()) +
-                             ", Active threads: " + std::to_string(pool.getActiveThreads()));
-    }
+    auto allResults = whenAll(results);
+    const auto& values = allResults.get();
+    LOG_INFO(logger, "Sum of task results: " + std::to_string(std::accumulate(values.begin(), values.end(), 0)));
 
     double avgTime, minTime, maxTime;
     pool.getStats(avgTime, minTime, maxTime);
@@ -340,6 +348,14 @@ void testThreadPool(LoggerWrapper& logger)
     ss << "Task statistics - Avg time: " << avgTime << "ms, Min time: " << minTime << "ms, Max time: " << maxTime
        << "ms";
     LOG_INFO(logger, ss.str());
+
+    auto latency = pool.getLatencyStats();
+    std::stringstream percentiles;
+    percentiles << "Queue wait p50/p90/p99/p999: " << latency.queueWait.p50 / 1000 << "/"
+                << latency.queueWait.p90 / 1000 << "/" << latency.queueWait.p99 / 1000 << "/"
+                << latency.queueWait.p999 / 1000 << "us, Execution p50/p99: " << latency.execution.p50 / 1000000
+                << "/" << latency.execution.p99 / 1000000 << "ms";
+    LOG_INFO(logger, percentiles.str());
     LOG_INFO(logger, "Total tasks processed: " + std::to_string(pool.getTotalTasks()));
 }
 
@@ -475,8 +491,10 @@ int main()
     std::vector<int> numArray(1000);
     std::iota(numArray.begin(), numArray.end(), 0);
 
-    std::for_each(std::execution::par_unseq, numArray.begin(), numArray.end(),
-                  [&logger](int num) { LOG_DEBUG(logger, "number: " + std::to_string(num)); });
+    // 并行算法与订阅系统共用一组工作线程
+    ThreadPool sharedPool(std::thread::hardware_concurrency(), ThreadPoolOptions{SchedulingMode::WorkStealing});
+    parallelFor(sharedPool, numArray.begin(), numArray.end(),
+                [&logger](int num) { LOG_DEBUG(logger, "number: " + std::to_string(num)); });
 
     // 测试 calculateSpeed 函数
     double distance = 1000.0;
@@ -485,7 +503,7 @@ int main()
     LOG_INFO(logger, "Speed 3: " + std::to_string(calculateSpeed(distance, SpeedParams3)));
 
     // 订阅测试
-    complexTestSubscriberSystem(logger);
+    complexTestSubscriberSystem(logger, sharedPool);
 
     // OpenCL测试
     testOpenCLWrapper();